@@ -78,6 +78,11 @@ void testApp::setup(){
 			yScale, yOffset); // Setup each oscilloscope panel
 	}
 
+	// Analog pins read as 10 bit integers; store them as such at half the memory
+	for (int i = 0; i < nScopes; i++) {
+		scopeWin.scopes.at(i).setSampleFormat(ofxScopeSampleFormat(ofxScopeSampleFormat::INT16));
+	}
+
 	selectedScope = 0; // Select all scopes for increment/decrement
 
 	isPaused = false;
@@ -107,9 +112,7 @@ void testApp::update(){
 			analogData1.at(i) = (arduino.getAnalog(i));
 			logData << analogData1.at(i) << ",";
 		}
-		if (!isPaused) {
-			scopeWin.scopes.at(0).updateData(analogData1);
-		}
+		scopeWin.scopes.at(0).updateData(analogData1);
 
 		// Scope 2 - Analog Data
 		vector<float> analogData2;
@@ -119,9 +122,7 @@ void testApp::update(){
 			logData << analogData2.at(i) << ",";
 		}
 
-		if (!isPaused) {
-			scopeWin.scopes.at(1).updateData(analogData2);
-		}
+		scopeWin.scopes.at(1).updateData(analogData2);
 
 		if (isRecording) {
 			logData << "\n";
@@ -246,6 +247,7 @@ void testApp::keyReleased(int key){
 
 	if (key == 32) { // Space Bar
 		isPaused = !isPaused;
+		scopeWin.setFrozen(isPaused);
 	}
 
 
@@ -121,6 +121,10 @@ void ofApp::keyReleased(int key) {
 
 	if (key == 32) { // Space Bar
 		isPaused = !isPaused;
+		for (int w = 0; w < scopeWins.size(); w++)
+		{
+			scopeWins.at(w).setFrozen(isPaused);
+		}
 	}
 
 
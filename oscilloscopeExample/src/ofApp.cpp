@@ -70,12 +70,10 @@ void ofApp::update() {
 	}
 	*/
 
-	// Add data to the scopes
-	if (!isPaused) {
-		for (int i = 0; i<nScopes; i++) {
-			scopeWin.scopes.at(i).updateData(data);
-			//scopeWin.scopes.at(i).updateData(array_data, data.at(0).size());
-		}
+	// Add data to the scopes (also while paused, so nothing is lost)
+	for (int i = 0; i<nScopes; i++) {
+		scopeWin.scopes.at(i).updateData(data);
+		//scopeWin.scopes.at(i).updateData(array_data, data.at(0).size());
 	}
 
 	/*
@@ -185,6 +183,7 @@ void ofApp::keyReleased(int key) {
 
 	if (key == 32) { // Space Bar
 		isPaused = !isPaused;
+		scopeWin.setFrozen(isPaused);
 	}
 
 
@@ -21,11 +21,26 @@
 */
 ofxScopePlot::ofxScopePlot(ofRectangle plotArea, ofColor zeroLineColor, 
 	ofColor backgroundColor, float plotLineWidth) {
+		_generation = 0;
+		_revision = 0;
+		_plotted = false;
 		setPosition(plotArea);
 		setZeroLineColor(zeroLineColor);
 		setBackgroundColor(backgroundColor);
 		setPlotLineWidth(plotLineWidth);
 		_yLims = pair<float, float>(0.f, 0.f);
+		_timeWindow = 0;
+		_retention = 0;
+		_scrollOffset = 0;
+		_historySeconds = 0;
+		_frozen = false;
+		_freezeCount = 0;
+		_copiedFreeze = 0;
+		_lineStrip.setMode(OF_PRIMITIVE_LINE_STRIP);
+		_vertexMode = OFX_SCOPE_VERTEX_MODE;
+		_renderMode = AUTO;
+		_decimationThreshold = OFX_SCOPE_DECIMATION_THRESHOLD;
+		_scrollingStrip = false;
 }
 
 /*
@@ -33,11 +48,26 @@ ofxScopePlot::ofxScopePlot(ofRectangle plotArea, ofColor zeroLineColor,
 */
 ofxScopePlot::ofxScopePlot(ofPoint min, ofPoint max, ofColor zeroLineColor,
 	ofColor backgroundColor, float plotLineWidth) {
+		_generation = 0;
+		_revision = 0;
+		_plotted = false;
 		setPosition(min, max);
 		setZeroLineColor(zeroLineColor);
 		setBackgroundColor(backgroundColor);
 		setPlotLineWidth(plotLineWidth);
 		_yLims = pair<float, float>(0.f, 0.f);
+		_timeWindow = 0;
+		_retention = 0;
+		_scrollOffset = 0;
+		_historySeconds = 0;
+		_frozen = false;
+		_freezeCount = 0;
+		_copiedFreeze = 0;
+		_lineStrip.setMode(OF_PRIMITIVE_LINE_STRIP);
+		_vertexMode = OFX_SCOPE_VERTEX_MODE;
+		_renderMode = AUTO;
+		_decimationThreshold = OFX_SCOPE_DECIMATION_THRESHOLD;
+		_scrollingStrip = false;
 }
 
 /*
@@ -59,14 +89,52 @@ ofxScopePlot::~ofxScopePlot() {
 */
 void ofxScopePlot::setup(float timeWindow, float sampFreq, std::vector<ofColor> variableColors, 
 	float yScale, float yOffset) {
+		setup(timeWindow, std::vector<float>(variableColors.size(), sampFreq), variableColors, yScale, yOffset);
+}
+
+/*
+** setup
+** Initializes the ScopePlot with a separate sampling frequency per variable.
+** Each variable keeps timeWindow * sampFreqs[i] points and all variables
+** are plotted on the same time axis.
+** 
+** INPUT:
+** timeWindow		Specifies the time in seconds of the oscilloscope window
+** sampFreqs		Specifies the sampling frequency of each variable
+** variableColors	Display colors of variables
+** yScale			Muliplier for Y scaling axis
+** yOffset			Offset for the Y axis
+*/
+void ofxScopePlot::setup(float timeWindow, std::vector<float> sampFreqs, std::vector<ofColor> variableColors,
+	float yScale, float yOffset) {
+		if (sampFreqs.size() != variableColors.size()) {
+			fprintf(stderr, "ERROR: sampFreqs.size() != variableColors.size()");
+			sampFreqs.resize(variableColors.size(), sampFreqs.empty() ? 0.f : sampFreqs.back());
+		}
 		_timeWindow = timeWindow;
-		_pointsPerWin = floor(_timeWindow * sampFreq); //(sec)
-		_sampFreq = sampFreq;
+		_retention = std::max(_retention, _timeWindow);
+		_sampFreqs = sampFreqs;
+		_sampFreq = 0;
+		for (int i = 0; i < _sampFreqs.size(); i++) {
+			_sampFreq = std::max(_sampFreq, _sampFreqs.at(i));
+		}
+		_pointsPerWin = floor(_timeWindow * _sampFreq); //(sec)
 		_nVariables = variableColors.size();
-		_buffer.clear();
-		for (int i=0; i<_nVariables; i++) {
-			_buffer.push_back(std::vector<float>(_pointsPerWin, 0.));
+
+		_buffer.setup(getCapacities());
+		_vertexBuffers.assign(_nVariables, ofxScopeVertexBuffer(_vertexMode));
+		_lttb.assign(_nVariables, ofxScopeLttb());
+		_strips.assign(_nVariables, ofxScopeStrip());
+		setFrozen(false);
+		setTimestamped(_buffer.isTimestamped());
+		updateWindows();
+		if (_queue.getCapacity() > 0) {
+			_queue.setup(_queue.getCapacity(), _nVariables);
+		}
+		if (_historySeconds > 0) {
+			setupHistory(_historyDirectory, _historySeconds);
 		}
+		publish();
 
 		setYScale(yScale);
 		setYOffset(yOffset);
@@ -105,22 +173,18 @@ void ofxScopePlot::setup(float timeWindow, float sampFreq, ofColor variableColor
 ** of variables initialized with setup. plot() may be called to display the 
 ** updated buffer.
 */
-void ofxScopePlot::updateData(std::vector<float> data) {
+void ofxScopePlot::updateData(const std::vector<float> &data) {
 #ifdef DEBUG_PRINT
 	printf("ofxScopePlot::updateData\n"); 
 #endif
 	if (data.size() != getNumVariables()) {
 		fprintf(stderr, "ERROR: data.size() != getNumVariables()");
-	} else {
+	} else if (acceptsUpdates()) {
 		for (int i=0; i<data.size(); i++) {
-
-			// Insert the data elements into the beginning of _buffer
-			_buffer.at(i).insert(_buffer.at(i).begin(), data.at(i));
-
-			// Erase elements at end of _buffer
-			_buffer.at(i).erase(_buffer.at(i).begin() + _pointsPerWin, _buffer.at(i).end());
-
+			// Append the data element to the ring buffer, overwriting the oldest sample
+			_buffer.push(i, data[i]);
 		}
+		publish();
 	}
 }
 
@@ -134,7 +198,7 @@ void ofxScopePlot::updateData(std::vector<float> data) {
 ** of variables initialized with setup. plot() may be called to display the 
 ** updated buffer.
 */
-void ofxScopePlot::updateData(std::vector<std::vector<float> > data) {
+void ofxScopePlot::updateData(const std::vector<std::vector<float> > &data) {
 #ifdef DEBUG_PRINT
 	printf("ofxScopePlot::updateData\n"); 
 #endif
@@ -142,19 +206,75 @@ void ofxScopePlot::updateData(std::vector<std::vector<float> > data) {
 		fprintf(stderr, "ERROR: data.size() != getNumVariables()");
 	} else {
 		for (int i=0; i<data.size(); i++) {
-			//int nPoints = data.at(i).size();
-			//int buffPoints = _buffer.at(i).size();
+			// Append the data elements (oldest first) to the ring buffer
+			updateData(i, data.at(i).data(), data.at(i).size());
+		}
+	}
+}
 
-			// Reverse the elements of incoming data
-			reverse(data.at(i).begin(), data.at(i).end());
+/*
+** updateData
+**
+** Data should come in the form data[nDataPoints * stride], oldest first,
+** with consecutive points of variableNum spaced stride floats apart.
+**
+** Copies the data straight from the caller's memory onto the ScopePlot
+** buffer of a single variable. plot() may be called to display the 
+** updated buffer.
+*/
+void ofxScopePlot::updateData(size_t variableNum, const float * data, size_t nPoints, size_t stride) {
+	if (variableNum >= getNumVariables()) {
+		fprintf(stderr, "ERROR: variableNum >= getNumVariables()");
+	} else if (acceptsUpdates()) {
+		_buffer.push(variableNum, data, nPoints, stride);
+		publish();
+	}
+}
 
-			// Insert the data elements into the beginning of _buffer
-			_buffer.at(i).insert(_buffer.at(i).begin(), data.at(i).begin(), data.at(i).end());
+/*
+** updateData
+**
+** Data should come in the form codes[nDataPoints * stride], oldest first:
+** raw integer samples, e.g. ADC readings.
+**
+** A variable stored as ofxScopeSampleFormat::INT16 keeps the codes as they
+** are; its scale and offset are applied when plotting. Other formats store
+** the codes as values.
+*/
+void ofxScopePlot::updateData(size_t variableNum, const int16_t * codes, size_t nPoints, size_t stride) {
+	if (variableNum >= getNumVariables()) {
+		fprintf(stderr, "ERROR: variableNum >= getNumVariables()");
+	} else if (acceptsUpdates()) {
+		_buffer.push(variableNum, codes, nPoints, stride);
+		publish();
+	}
+}
 
-			// Erase elements at end of _buffer
-			_buffer.at(i).erase(_buffer.at(i).begin() + _pointsPerWin, _buffer.at(i).end());
+/*
+** updateData
+**
+** Data should come in the form data[nDataPoints], oldest first
+**
+** Loads a view of caller memory onto the ScopePlot buffer of a single variable.
+*/
+void ofxScopePlot::updateData(size_t variableNum, ofxScopeSpan data) {
+	updateData(variableNum, data.data, data.size, data.stride);
+}
 
-			int junk;
+/*
+** updateData
+**
+** Data should come in the form data[nVariables][nDataPoints]
+**
+** Loads one view of caller memory per variable onto the ScopePlot buffer.
+** Must have the same number of variables initialized with setup.
+*/
+void ofxScopePlot::updateData(const ofxScopeSpan data[], int nVariables) {
+	if (nVariables != getNumVariables()) {
+		fprintf(stderr, "ERROR: nVariables != getNumVariables()");
+	} else {
+		for (int i=0; i<nVariables; i++) {
+			updateData(i, data[i]);
 		}
 	}
 }
@@ -171,27 +291,232 @@ void ofxScopePlot::updateData(std::vector<std::vector<float> > data) {
 ** updated buffer.
 */
 void ofxScopePlot::updateData(float ** data, int nPoints) {
+	for (int i=0; i<getNumVariables(); i++) {
+		updateData(i, data[i], nPoints);
+	}
+}
 
-	std::vector< std::vector<float> > vec_data;
+/*
+** updateData
+**
+** Data should come in the form data[nVariables] with one data point/variable,
+** all sampled at timestamp (seconds).
+**
+** Only meaningful after setTimestamped(true); otherwise the timestamp is ignored.
+*/
+void ofxScopePlot::updateData(const std::vector<float> &data, double timestamp) {
+	if (data.size() != getNumVariables()) {
+		fprintf(stderr, "ERROR: data.size() != getNumVariables()");
+	} else if (acceptsUpdates()) {
+		for (int i=0; i<data.size(); i++) {
+			_buffer.push(i, &data[i], &timestamp, 1);
+		}
+		publish();
+	}
+}
 
-	vec_data.resize(getNumVariables());
-	for (int i=0; i<getNumVariables(); i++) {
-		vec_data.at(i).resize(nPoints);
-		for (int j=0; j<nPoints; j++) {
-			vec_data.at(i).at(j) = data[i][j];
+/*
+** updateData
+**
+** Data should come in the form data[nDataPoints * stride] with
+** timestamps[nDataPoints] in seconds, oldest first.
+**
+** Timestamps that go backwards are clamped to the previous timestamp.
+*/
+void ofxScopePlot::updateData(size_t variableNum, const float * data, const double * timestamps,
+	size_t nPoints, size_t stride) {
+	if (variableNum >= getNumVariables()) {
+		fprintf(stderr, "ERROR: variableNum >= getNumVariables()");
+	} else if (acceptsUpdates()) {
+		_buffer.push(variableNum, data, timestamps, nPoints, stride);
+		publish();
+	}
+}
+
+/*
+** setTimestamped
+** Stores a timestamp with every sample and positions samples on the x-axis
+** by time rather than by index, so irregular or bursty streams plot correctly.
+** Samples updated without timestamps are spaced 1/sampFreq after the previous one.
+** Only the newest timeWindow seconds are plotted and autoscaled.
+*/
+void ofxScopePlot::setTimestamped(bool timestamped) {
+	_buffer.setTimestamped(timestamped, 1. / _sampFreq);
+	for (int i = 0; i < _buffer.getNumChannels() && i < _sampFreqs.size(); i++) {
+		_buffer.setTimestampInterval(i, 1. / _sampFreqs.at(i));
+	}
+	publish();
+}
+
+bool ofxScopePlot::isTimestamped() {
+	return _buffer.isTimestamped();
+}
+
+/*
+** getNewestTimestamp
+** Returns the newest timestamp across all variables; the right edge of a
+** timestamped plot.
+*/
+double ofxScopePlot::getNewestTimestamp() {
+	ofxScopeView view = getView();
+	double newest = std::numeric_limits<double>::lowest();
+	if (!view.isTimestamped()) return newest;
+	for (int i = 0; i < view.getNumChannels(); i++) {
+		newest = std::max(newest, view.getNewestTimestamp(i));
+	}
+	return newest;
+}
+
+/*
+** updateDataInterleaved
+**
+** Data should come in the form frames[nFrames][nVariables], i.e.
+** [t0: var0..varN][t1: var0..varN]... oldest first
+**
+** Deinterleaves the frames directly onto the ScopePlot buffer. nVariables must
+** match the number of variables initialized with setup; otherwise nothing is
+** written and false is returned.
+*/
+bool ofxScopePlot::updateDataInterleaved(const float * frames, size_t nFrames, int nVariables) {
+#ifdef DEBUG_PRINT
+	printf("ofxScopePlot::updateDataInterleaved\n"); 
+#endif
+	if (!acceptsUpdates()) return false;
+	if (!_buffer.pushInterleaved(frames, nFrames, nVariables)) {
+		fprintf(stderr, "ERROR: nVariables != getNumVariables()");
+		return false;
+	}
+	publish();
+	return true;
+}
+
+/*
+** updateDataInterleaved
+**
+** Data should come in the form frames[nFrames * nVariables]
+*/
+bool ofxScopePlot::updateDataInterleaved(const std::vector<float> &frames, int nVariables) {
+	if (nVariables <= 0 || frames.size() % nVariables != 0) {
+		fprintf(stderr, "ERROR: frames.size() is not a multiple of nVariables");
+		return false;
+	}
+	return updateDataInterleaved(frames.data(), frames.size() / nVariables, nVariables);
+}
+
+/*
+** setupQueue
+** Creates a lock-free single-producer/single-consumer queue holding capacity
+** frames of one sample per variable. One acquisition thread may then call
+** pushData while the render thread draws; queued frames are moved into the
+** plot buffer at the start of plot(). Frames pushed while the queue is full
+** are dropped and counted by getOverruns().
+**
+** The thread draining the queue is then the only writer of the plot buffer,
+** so updateData is refused while a queue is set up.
+**
+** Must be called after setup and before the producer thread starts.
+*/
+void ofxScopePlot::setupQueue(size_t capacity) {
+	_queue.setup(capacity, _nVariables);
+}
+
+/*
+** acceptsUpdates
+** Returns true if updateData may write to the plot buffer: not while a queue
+** is set up, whose drain on the render thread is the buffer's only writer.
+*/
+bool ofxScopePlot::acceptsUpdates() {
+	if (_queue.getCapacity() > 0) {
+		fprintf(stderr, "ERROR: updateData on a plot fed through setupQueue; use pushData\n");
+		return false;
+	}
+	return true;
+}
+
+/*
+** pushData
+** Queues one frame[_nVariables] from the producer thread. Returns false if the
+** queue is full or wasn't set up. Every variable gets one sample per frame.
+*/
+bool ofxScopePlot::pushData(const float * frame) {
+	return _queue.push(frame);
+}
+
+bool ofxScopePlot::pushData(const std::vector<float> &data) {
+	if (data.size() != _queue.getFrameSize()) {
+		fprintf(stderr, "ERROR: data.size() != getNumVariables()");
+		return false;
+	}
+	return _queue.push(data.data());
+}
+
+bool ofxScopePlot::pushData(const std::vector<float> &data, double timestamp) {
+	if (data.size() != _queue.getFrameSize()) {
+		fprintf(stderr, "ERROR: data.size() != getNumVariables()");
+		return false;
+	}
+	return _queue.push(data.data(), timestamp);
+}
+
+/*
+** pushDataInterleaved
+** Queues frames[nFrames][_nVariables] (oldest first) from the producer thread.
+** Returns the number of frames queued; the rest are counted as overruns.
+*/
+size_t ofxScopePlot::pushDataInterleaved(const float * frames, size_t nFrames) {
+	return _queue.push(frames, NULL, nFrames);
+}
+
+/*
+** drainQueue
+** Moves every queued frame into the plot buffer. Called from the render
+** thread; plot() does this automatically. Returns the number of frames moved.
+*/
+size_t ofxScopePlot::drainQueue() {
+	size_t nDrained = 0;
+	const float * frames;
+	const double * timestamps;
+	size_t nFrames;
+	while ((nFrames = _queue.peek(frames, timestamps)) > 0) {
+		if (_buffer.isTimestamped()) {
+			for (int i = 0; i < _nVariables; i++) {
+				_buffer.push(i, frames + i, timestamps, nFrames, _nVariables);
+			}
+		} else {
+			_buffer.pushInterleaved(frames, nFrames, _nVariables);
 		}
-		//vec_data.at(i).assign(data[i], data[i] + nPoints
+		_queue.pop(nFrames);
+		nDrained += nFrames;
+	}
+	if (nDrained > 0) {
+		publish();
 	}
-	updateData(vec_data);
+	return nDrained;
+}
+
+/*
+** getOverruns
+** Returns the number of frames dropped because the queue was full.
+*/
+uint64_t ofxScopePlot::getOverruns() {
+	return _queue.getOverruns();
+}
+
+uint64_t ofxScopePlot::resetOverruns() {
+	return _queue.resetOverruns();
 }
 
 void ofxScopePlot::clearData() {
-	for (int i = 0; i < _buffer.size(); i++) {
-		if (_buffer.at(i).size() > 0) {
-			float lastVal = _buffer.at(i).at(0);
-			_buffer.at(i).assign(_buffer.at(i).size(), lastVal);
-		}
+	for (int i = 0; i < _buffer.getNumChannels(); i++) {
+		if (_buffer.getCapacity(i) == 0) continue;
+		_buffer.fill(i, _buffer.newest(i));
+	}
+	for (int i = 0; i < _vertexBuffers.size(); i++) {
+		_vertexBuffers.at(i).invalidate();
+		_lttb.at(i).invalidate();
+		_strips.at(i).invalidate();
 	}
+	publish();
 }
 
 
@@ -205,6 +530,7 @@ void ofxScopePlot::setVariableColors(std::vector<ofColor> colors) {
 		fprintf(stderr, "ERROR: colors.size() != getNumVariables()");
 	} else {
 		_variableColors = colors;
+		_revision++;
 	}
 }
 
@@ -227,6 +553,7 @@ void ofxScopePlot::setVariableColors(ofColor colors[], int nColors) {
 */
 void ofxScopePlot::setPlotLineWidth(float plotLineWidth) {
 	_plotLineWidth = plotLineWidth;
+	_revision++;
 }
 
 /*
@@ -235,6 +562,7 @@ void ofxScopePlot::setPlotLineWidth(float plotLineWidth) {
 */
 void ofxScopePlot::setZeroLineColor(ofColor zeroLineColor) {
 	_zeroLineColor = zeroLineColor;
+	_revision++;
 }
 
 /*
@@ -243,6 +571,15 @@ void ofxScopePlot::setZeroLineColor(ofColor zeroLineColor) {
 */
 void ofxScopePlot::setBackgroundColor(ofColor backgroundColor) {
 	_backgroundColor = backgroundColor;
+	_revision++;
+}
+
+ofColor ofxScopePlot::getZeroLineColor() {
+	return _zeroLineColor;
+}
+
+ofColor ofxScopePlot::getBackgroundColor() {
+	return _backgroundColor;
 }
 
 /*
@@ -252,6 +589,7 @@ void ofxScopePlot::setBackgroundColor(ofColor backgroundColor) {
 void  ofxScopePlot::setPosition(ofPoint min, ofPoint max) {
 	_min = min;
 	_max = max;
+	_revision++;
 }
 void  ofxScopePlot::setPosition(ofRectangle plotArea) {
 	setPosition(plotArea.getTopLeft(), plotArea.getBottomRight());
@@ -268,22 +606,140 @@ ofRectangle ofxScopePlot::getPosition() {
 
 /*
 ** setTimeWindow
-** Sets the timeWindow covered by the scope.
+** Sets the timeWindow covered by the scope. Samples are kept for the
+** retention, so shrinking and growing the window back loses no data and
+** doesn't touch the buffer storage. Growing past the retention extends it.
 */ 
 void ofxScopePlot::setTimeWindow(float timeWindow) {
 	_timeWindow = timeWindow;
 	_pointsPerWin = floor(_timeWindow * _sampFreq); //(sec)
-	for (int i=0; i<_nVariables; i++) {
-		_buffer.at(i).resize(_pointsPerWin);
+	if (_timeWindow > _retention && !hasHistory()) {
+		// Zooming out past the retained history; grow once and keep what we have
+		_retention = _timeWindow;
+		_buffer.resize(getCapacities());
+	}
+	updateWindows();
+	publish();
+}
+
+/*
+** setRetention
+** Sets how many seconds of samples the scope keeps, independent of the
+** displayed timeWindow (never less than it). Zooming the time axis within
+** the retention is instant and keeps all data. Reallocates the buffer,
+** keeping the newest samples.
+*/
+void ofxScopePlot::setRetention(float retention) {
+	_retention = std::max(retention, _timeWindow);
+	if (_buffer.getNumChannels() > 0) {
+		_buffer.resize(getCapacities());
+		updateWindows();
+		publish();
 	}
 }
 
+float ofxScopePlot::getRetention() {
+	return _retention;
+}
+
+/*
+** setupHistory
+** Spills samples evicted from the buffer into memory-mapped segment files
+** in directory, keeping up to seconds of data per variable on disk. The
+** time window may then exceed the retention and setScrollOffset can scroll
+** back through the history; only the segments in view are read. Timestamped
+** scopes plot from the buffer only. Call after setup. An empty directory
+** keeps the history compressed in memory instead, see setupCompressedHistory.
+*/
+void ofxScopePlot::setupHistory(string directory, float seconds) {
+	static int nHistories = 0;
+	_historyDirectory = directory;
+	_historySeconds = std::max(seconds, 0.f);
+	string id = ofToString(ofGetUnixTime()) + "_" + ofToString(nHistories++);
+	for (int i = 0; i < _buffer.getNumChannels(); i++) {
+		std::shared_ptr<ofxScopeHistoryTier> history;
+		size_t maxSamples = (size_t) ceil(seconds * _sampFreqs.at(i));
+		if (seconds > 0 && directory.empty()) {
+			history = std::make_shared<ofxScopeCompressedHistory>(maxSamples);
+		} else if (seconds > 0) {
+			string pathPrefix = ofFilePath::join(directory, "ofxScopeHistory_" + id + "_" + ofToString(i) + "_");
+			history = std::make_shared<ofxScopeMappedHistory>(pathPrefix, maxSamples);
+		}
+		_buffer.setHistory(i, history);
+	}
+	_revision++;
+}
+
+/*
+** setupCompressedHistory
+** Like setupHistory, but seals blocks of evicted samples in memory with
+** XOR (Gorilla style) compression. Each block keeps its min/max, so zoomed
+** out plots and autoscaling read whole blocks without decompressing them.
+*/
+void ofxScopePlot::setupCompressedHistory(float seconds) {
+	setupHistory("", seconds);
+}
+
+bool ofxScopePlot::hasHistory() {
+	return _buffer.getNumChannels() > 0 && _buffer.getHistory(0) != NULL;
+}
+
+/*
+** setScrollOffset
+** Scrolls back so the right edge of the plot shows the data of seconds ago.
+** Limited to the oldest data held by the buffer and its history.
+*/
+void ofxScopePlot::setScrollOffset(float seconds) {
+	_scrollOffset = std::max(seconds, 0.f);
+	_revision++;
+}
+
+float ofxScopePlot::getScrollOffset() {
+	return _scrollOffset;
+}
+
+/*
+** getVisibleEnd
+** Returns the index after the newest sample of variable i at the right edge
+** of the plot, accounting for the scroll offset.
+*/
+uint64_t ofxScopePlot::getVisibleEnd(const ofxScopeView &view, int i) {
+	uint64_t last = view.getNumWritten(i);
+	uint64_t offset = (uint64_t) floor(_scrollOffset * _sampFreqs.at(i));
+	return last - std::min(offset, last - view.getOldestIndex(i));
+}
+
+/*
+** getCapacities
+** Returns the buffer capacity of each variable: the retention plus the
+** render slack.
+*/
+std::vector<size_t> ofxScopePlot::getCapacities() {
+	std::vector<size_t> capacities(_sampFreqs.size());
+	for (int i = 0; i < capacities.size(); i++) {
+		capacities.at(i) = (size_t) floor(_retention * _sampFreqs.at(i)) + getRenderSlack(i);
+	}
+	return capacities;
+}
+
+/*
+** updateWindows
+** Points the buffer's window extremes at the samples of the timeWindow.
+*/
+void ofxScopePlot::updateWindows() {
+	for (int i = 0; i < _buffer.getNumChannels(); i++) {
+		_buffer.setWindow(i, getPointsPerWin(i));
+	}
+	_buffer.setTimeWindow(_timeWindow);
+}
+
 /*
 ** setYScale
 ** Sets the yScale of the data in the oscilloscope window.
 */ 
 void ofxScopePlot::setYScale(float yScale) {
 	_yScale = yScale;
+	_revision++;
 }
 
 /*
@@ -300,6 +756,7 @@ float ofxScopePlot::getYScale() {
 */ 
 void ofxScopePlot::setYOffset(float yOffset) {
 	_yOffset = yOffset;
+	_revision++;
 }
 
 /*
@@ -313,18 +770,34 @@ float ofxScopePlot::getYOffset() {
 /*
 ** getMinMaxY
 ** Returns the min and max values of the data in the oscilloscope window as an std::pair
+** O(nVariables); the buffer keeps running window extremes as data is appended.
 */
 pair<float, float> ofxScopePlot::getMinMaxY() {
-	vector<float> minMaxY;
-	for (int j = 0; j < _buffer.size(); j++) {
-		// calculate the min and max for each plot in the scope 
-		auto result = std::minmax_element(_buffer.at(j).begin(), _buffer.at(j).end());
-		minMaxY.push_back(*result.first);
-		minMaxY.push_back(*result.second);
+	bool found = false;
+	pair<float, float> minMaxY(0.f, 0.f);
+	ofxScopeView view = getView();
+	for (int j = 0; j < view.getNumChannels(); j++) {
+		// min and max of each plot in the scope, maintained incrementally as samples arrive
+		float min, max;
+		bool inWindow;
+		if (_scrollOffset <= 0 && getPointsPerWin(j) <= view.getCapacity(j)) {
+			inWindow = view.getWindowMinMax(j, min, max);
+		} else {
+			// Scrolled back or reaching into the history; extremes read from
+			// samples ingest overwrote meanwhile are left out
+			uint64_t last = getVisibleEnd(view, j);
+			inWindow = last >= getPointsPerWin(j) &&
+				view.getMinMax(j, last - getPointsPerWin(j), last, min, max) &&
+				view.isIntact(j, last - getPointsPerWin(j));
+		}
+		if (inWindow) {
+			minMaxY.first = found ? std::min(minMaxY.first, min) : min;
+			minMaxY.second = found ? std::max(minMaxY.second, max) : max;
+			found = true;
+		}
 	}
 	// return the min and max across all scope plots
-	auto result = std::minmax_element(minMaxY.begin(), minMaxY.end());
-	return std::pair<float, float>(*(result.first), *(result.second));
+	return minMaxY;
 }
 
 /*
@@ -346,19 +819,29 @@ pair<float, float> ofxScopePlot::getYLims() {
 
 /*
 ** plot
-** Plots the data in the buffer
+** Plots the data in the buffer as of the most recent update. Draws from a
+** published snapshot, so one other thread may keep calling updateData while
+** a frame is drawn. Ingest up to OFX_SCOPE_RENDER_SLACK seconds of samples
+** ahead never touches what is drawn; a variable whose samples were overwritten
+** further ahead while they were read is drawn again from past them (see
+** ofxScopeView::isIntact). setup and setTimeWindow must not run concurrently.
+** Each variable is drawn as one line strip. Samples held by the ring come from
+** the variable's vertex buffer, which receives only samples new since the
+** last frame; samples scrolled back into a history tier are streamed. With
+** setScrollingStrip, each variable is instead drawn from an offscreen strip
+** that only rasterizes samples new since the last frame.
 */
 void ofxScopePlot::plot() {
-	// ToDo:: simplify code to use ofPushMatrix()
-
-	//float xPlotScale = ofGetWindowSize().x / _pointsPerWin * ofGetWindowSize().x / (_max.x - _min.x);
-	float xPlotScale = (_max.x - _min.x) / (_pointsPerWin - 1);// * (_max.x - _min.x) / ofGetWindowSize().x;
-	float yPlotScale = (_max.y - _min.y) / ofGetWindowSize().y;
-	float yPlotOffset = ((_max.y - _min.y) / 2.);
-	//printf("xPlotScale: %f, yPlotScale: %f, yPlotOffset: %f\n", xPlotScale, yPlotScale, yPlotOffset);
-	//ofScale(1., 1., 1.);
+	plotBackground();
+	plotTraces();
+}
 
-	// Background
+/*
+** plotBackground
+** Draws the background and the zero line. Owners that cache these (see
+** ofxOscilloscope) call plotTraces alone.
+*/
+void ofxScopePlot::plotBackground() {
 	ofEnableAlphaBlending();
 	ofSetColor(_backgroundColor);
 	ofRect(ofRectangle(_min, _max));
@@ -367,31 +850,310 @@ void ofxScopePlot::plot() {
 	ofSetColor(_zeroLineColor);
 	ofLine(_min.x, _min.y + (_max.y - _min.y)/2, _max.x, _min.y + (_max.y - _min.y)/2);
 	ofDisableAlphaBlending(); 
+}
+
+/*
+** plotTraces
+** Draws the variables over the background; see plot.
+*/
+void ofxScopePlot::plotTraces() {
+	// ToDo:: simplify code to use ofPushMatrix()
+
+	drainQueue();
 
+	float yPlotScale = (_max.y - _min.y) / ofGetWindowSize().y;
+	float yPlotOffset = ((_max.y - _min.y) / 2.);
+	//printf("xPlotScale: %f, yPlotScale: %f, yPlotOffset: %f\n", xPlotScale, yPlotScale, yPlotOffset);
+	//ofScale(1., 1., 1.);
+
+	// Draw from the latest published frame so ingestion on another thread
+	// can continue while this frame is drawn
+	ofxScopeView view = getView();
+	_plotted = true;
+	_plottedGeneration = view.getGeneration();
+	_plottedRevision = _revision;
+	_plottedWindowHeight = ofGetWindowHeight();
+
+	if (view.isTimestamped()) {
+		plotTimestamped(view, yPlotScale, yPlotOffset);
+		return;
+	}
+
+	float plotWidth = _max.x - _min.x;
 	for (int i=0; i<getNumVariables(); i++) {
+		// Every variable spans the whole time window, so slower variables
+		// get a proportionally larger x step
+		int pointsPerWin = getPointsPerWin(i);
+		if (pointsPerWin < 2) continue;	// Window shorter than two samples of this variable
+		//float xPlotScale = ofGetWindowSize().x / _pointsPerWin * ofGetWindowSize().x / (_max.x - _min.x);
+		float xPlotScale = plotWidth / (pointsPerWin - 1);// * (_max.x - _min.x) / ofGetWindowSize().x;
+
 		ofSetColor(_variableColors.at(i));
 		ofSetLineWidth(_plotLineWidth);
-		for (int j=1; j<_pointsPerWin; j++) {
-			ofPoint p1 = ofPoint(_max.x-((float)(j-1)*xPlotScale),  
-				_max.y-(yPlotScale*((_buffer.at(i).at(j-1) * _yScale + _yOffset)) + yPlotOffset));
+		if (!plotVariable(view, i, view.getOldestIndex(i), pointsPerWin, xPlotScale, yPlotScale, yPlotOffset)) {
+			// Ingest ran more than the render slack ahead and overwrote samples
+			// while they were read; draw once more from a render slack past them
+			plotVariable(view, i, view.getIntactOldest(i) + getRenderSlack(i),
+				pointsPerWin, xPlotScale, yPlotScale, yPlotOffset);
+		}
+	}
+}
+
+/*
+** plotVariable
+** Draws variable i with the newest visible sample at the right edge, reading
+** no sample older than oldest. Every path reads first and draws only if the
+** view reports what it read intact; returns false, having drawn nothing, if
+** not.
+*/
+bool ofxScopePlot::plotVariable(const ofxScopeView &view, int i, uint64_t oldest, int pointsPerWin,
+	float xPlotScale, float yPlotScale, float yPlotOffset) {
+	// With many samples per pixel column, plot the min/max envelope of each
+	// column instead of every sample so no peak is lost. LTTB's kept samples
+	// are not fixed once drawn, so it is never drawn from a strip
+	bool decimated = isDecimated(pointsPerWin);
+	if (decimated && _renderMode == LTTB) {
+		return plotLttb(view, i, oldest, pointsPerWin, xPlotScale, yPlotScale, yPlotOffset);
+	}
+	if (_scrollingStrip) {
+		return plotStrip(view, i, oldest, pointsPerWin, xPlotScale, yPlotScale, yPlotOffset);
+	}
+	if (decimated) {
+		return plotEnvelope(view, i, oldest, pointsPerWin, xPlotScale, yPlotScale, yPlotOffset);
+	}
+	return plotLine(view, i, oldest, pointsPerWin, xPlotScale, yPlotScale, yPlotOffset);
+}
+
+/*
+** getVisibleStart
+** Returns the oldest index drawn with last as the newest: pointsPerWin back,
+** but not before oldest.
+*/
+uint64_t ofxScopePlot::getVisibleStart(uint64_t last, int pointsPerWin, uint64_t oldest) {
+	return last - std::min((uint64_t) pointsPerWin, last - std::min(oldest, last));
+}
+
+/*
+** plotLine
+** Plots variable i with one vertex per sample. Samples held by the ring come
+** from the variable's vertex buffer; samples scrolled back into a history
+** tier are streamed.
+*/
+bool ofxScopePlot::plotLine(const ofxScopeView &view, int i, uint64_t oldest, int pointsPerWin,
+	float xPlotScale, float yPlotScale, float yPlotOffset) {
+	// Screen y = yCodeScale * code + yCodeOffset: the stored code goes to the
+	// screen in one step, with an INT16 variable's scale and offset folded in
+	const ofxScopeSampleFormat &format = view.getSampleFormat(i);
+	float yCodeScale = -yPlotScale * _yScale * format.scale;
+	float yCodeOffset = _max.y - (yPlotScale * (format.offset * _yScale + _yOffset) + yPlotOffset);
+	uint64_t last = getVisibleEnd(view, i);
+	uint64_t first = getVisibleStart(last, pointsPerWin, oldest);
+	if (last - first < 2) return true;
+
+	// Mirror what the ring holds beyond the render slack, which ingest may overwrite
+	ofxScopeVertexBuffer &vertices = _vertexBuffers.at(i);
+	uint64_t written = view.getNumWritten(i);
+	vertices.update(view, i, written - std::min(written, (uint64_t) (view.getCapacity(i) - getRenderSlack(i))));
+	if (vertices.holds(first, last)) {
+		vertices.draw(first, last, _max.x, xPlotScale, yCodeScale, yCodeOffset);
+		return true;
+	}
+
+	// Newest sample at the right edge, one vertex per sample
+	_lineStrip.clear();
+	for (uint64_t n = last; n-- > first; ) {
+		_lineStrip.addVertex(ofPoint(_max.x-((float)(last-1-n)*xPlotScale),
+			yCodeScale * view.codeAtIndex(i, n) + yCodeOffset));
+	}
+	if (!view.isIntact(i, first)) return false;
+	_lineStrip.draw();
+	return true;
+}
+
+/*
+** plotEnvelope
+** Plots the min/max envelope of variable i with one bucket of samples per
+** pixel column. Buckets are aligned to absolute sample indexes so the envelope
+** scrolls without shimmering, and each bucket's extremes come from the pyramid
+** in the buffer rather than a scan of its samples.
+*/
+bool ofxScopePlot::plotEnvelope(const ofxScopeView &view, int i, uint64_t oldest, int pointsPerWin,
+	float xPlotScale, float yPlotScale, float yPlotOffset) {
+	if (pointsPerWin < 1) return true;
+	float plotWidth = _max.x - _min.x;
+	uint64_t samplesPerBucket = std::max((uint64_t) ceil(pointsPerWin / plotWidth), (uint64_t) 1);
+
+	uint64_t last = getVisibleEnd(view, i);
+	uint64_t first = getVisibleStart(last, pointsPerWin, oldest);
+	// Each bucket adds its min then its max, so the strip draws the bucket's
+	// vertical span and the join to the next bucket
+	_lineStrip.clear();
+	for (uint64_t b = first / samplesPerBucket; b * samplesPerBucket < last; b++) {
+		float min, max;
+		uint64_t bucketStart = std::max(b * samplesPerBucket, first);
+		uint64_t bucketEnd = std::min((b + 1) * samplesPerBucket, last);
+		if (!view.getMinMax(i, bucketStart, bucketEnd, min, max)) continue;
+
+		float age = (float) (last - 1 - bucketStart) - (bucketEnd - 1 - bucketStart) / 2.f;
+		float x = _max.x - age * xPlotScale;
+		_lineStrip.addVertex(ofPoint(x, _max.y-(yPlotScale*((min * _yScale + _yOffset)) + yPlotOffset)));
+		_lineStrip.addVertex(ofPoint(x, _max.y-(yPlotScale*((max * _yScale + _yOffset)) + yPlotOffset)));
+	}
+	if (!view.isIntact(i, first)) return false;
+	_lineStrip.draw();
+	return true;
+}
+
+/*
+** plotLttb
+** Plots variable i reduced by LTTB to about getLttbPoints() samples. Only
+** buckets that scrolled in since the previous frame are computed; choices
+** made from overwritten samples are forgotten.
+*/
+bool ofxScopePlot::plotLttb(const ofxScopeView &view, int i, uint64_t oldest, int pointsPerWin,
+	float xPlotScale, float yPlotScale, float yPlotOffset) {
+	const ofxScopeSampleFormat &format = view.getSampleFormat(i);
+	float yCodeScale = -yPlotScale * _yScale * format.scale;
+	float yCodeOffset = _max.y - (yPlotScale * (format.offset * _yScale + _yOffset) + yPlotOffset);
+	uint64_t last = getVisibleEnd(view, i);
+	uint64_t first = getVisibleStart(last, pointsPerWin, oldest);
+	const std::vector<ofxScopeLttb::Point> &points = _lttb.at(i).select(view, i, first, last, getLttbPoints());
+	if (!view.isIntact(i, first)) {
+		_lttb.at(i).invalidate();
+		return false;
+	}
+
+	_lineStrip.clear();
+	for (size_t n = 0; n < points.size(); n++) {
+		_lineStrip.addVertex(ofPoint(_max.x - (float) (last - 1 - points[n].index) * xPlotScale,
+			yCodeScale * points[n].code + yCodeOffset));
+	}
+	_lineStrip.draw();
+	return true;
+}
+
+/*
+** plotStrip
+** Draws variable i from its scrolling strip, as plotTraces would draw it
+** directly: every sample, or the min/max envelope when decimated. The strip
+** rasterizes only samples appended since the previous frame.
+*/
+bool ofxScopePlot::plotStrip(const ofxScopeView &view, int i, uint64_t oldest, int pointsPerWin,
+	float xPlotScale, float yPlotScale, float yPlotOffset) {
+	bool decimated = isDecimated(pointsPerWin);
+	float plotWidth = _max.x - _min.x;
+	const ofxScopeSampleFormat &format = view.getSampleFormat(i);
+	ofxScopeStrip::Style style;
+	style.xStep = xPlotScale;
+	style.bucketSize = decimated ? (uint64_t) ceil(pointsPerWin / plotWidth) : 0;
+	style.color = _variableColors.at(i);
+	style.lineWidth = _plotLineWidth;
+	style.width = (int) floor(plotWidth + 0.5f);
+	style.height = (int) floor(_max.y - _min.y + 0.5f);
+
+	uint64_t last = getVisibleEnd(view, i);
+	uint64_t first = getVisibleStart(last, pointsPerWin, oldest);
+	if (!decimated && last - first < 2) return true;
+	// The y transform is applied when compositing, so autoscaling does not
+	// redraw the strip every frame
+	float yCodeScale = -yPlotScale * _yScale * format.scale;
+	float yCodeOffset = _max.y - (yPlotScale * (format.offset * _yScale + _yOffset) + yPlotOffset) - _min.y;
+	return _strips.at(i).plot(view, i, first, last, style, yCodeScale, yCodeOffset, _min.x, _min.y);
+}
+
+/*
+** plotTimestamped
+** Plots timestamped data. x-positions come from each sample's timestamp
+** relative to the newest timestamp of the scope, and the visible range of
+** each variable is located by binary search. Dense ranges are reduced to a
+** min/max envelope with one bucket per pixel column, aligned to absolute time;
+** LTTB buckets by sample count, so it also falls back to the envelope here.
+*/
+void ofxScopePlot::plotTimestamped(const ofxScopeView &view, float yPlotScale, float yPlotOffset) {
+	float plotWidth = _max.x - _min.x;
+	if (plotWidth < 1 || _timeWindow <= 0) return;
 
-			ofPoint p2 = ofPoint(_max.x-((float)(j)*xPlotScale), 
-				_max.y-(yPlotScale*((_buffer.at(i).at(j) * _yScale + _yOffset)) + yPlotOffset));
+	double newestTime = std::numeric_limits<double>::lowest();
+	for (int i = 0; i < view.getNumChannels(); i++) {
+		newestTime = std::max(newestTime, view.getNewestTimestamp(i));
+	}
+	double oldestTime = newestTime - _timeWindow;
+	double xTimeScale = plotWidth / _timeWindow;
+	double bucketTime = _timeWindow / plotWidth;
+
+	for (int i=0; i<getNumVariables(); i++) {
+		ofSetColor(_variableColors.at(i));
+		ofSetLineWidth(_plotLineWidth);
 
-			ofLine(p1, p2);
-			//printf("[%i, %i]: ofLine([%.1f, %.1f], [%.1f, %.1f]): buffer[%.1f],[%.1f]\n", i, j, p1.x, p1.y, p2.x, p2.y, _buffer[i][j-1], _buffer[i][j]);
-			//ofLine(_max.x-(float)(j-1), (_buffer[i][j-1] * _yScale) + yPlotOffset, _max.x-(float)j, (_buffer[i][j] * _yScale) + yPlotOffset);
-			//printf("[%i, %i]: ofLine(%f, %f, %f, %f)\n", i, j, _max.x-(float)(j-1), (_buffer[i][j-1] * _yScale) + yPlotOffset, _max.x-(float)j, (_buffer[i][j] * _yScale) + yPlotOffset);
+		// As in plotTraces, samples overwritten while they were read are read
+		// once more from a render slack past them
+		uint64_t last = view.getNumWritten(i);
+		uint64_t first = view.findIndex(i, oldestTime);
+		for (int attempt = 0; attempt < 2 && first < last; attempt++) {
+			_lineStrip.clear();
+			if (!isDecimated(last - first)) {
+				for (uint64_t n = first; n < last; n++) {
+					_lineStrip.addVertex(ofPoint(_max.x - (float) ((newestTime - view.timestampAtIndex(i, n)) * xTimeScale),
+						_max.y-(yPlotScale*((view.atIndex(i, n) * _yScale + _yOffset)) + yPlotOffset)));
+				}
+			} else {
+				uint64_t bucketStart = first;
+				for (double b = floor(view.timestampAtIndex(i, first) / bucketTime); bucketStart < last; b++) {
+					uint64_t bucketEnd = view.findIndex(i, (b + 1) * bucketTime);
+					float min, max;
+					if (!view.getMinMax(i, bucketStart, bucketEnd, min, max)) continue;
+
+					float x = _max.x - (float) ((newestTime - (b + 0.5) * bucketTime) * xTimeScale);
+					x = std::max(x, _min.x);
+					_lineStrip.addVertex(ofPoint(x, _max.y-(yPlotScale*((min * _yScale + _yOffset)) + yPlotOffset)));
+					_lineStrip.addVertex(ofPoint(x, _max.y-(yPlotScale*((max * _yScale + _yOffset)) + yPlotOffset)));
+					bucketStart = bucketEnd;
+				}
+			}
+			if (view.isIntact(i, first)) {
+				_lineStrip.draw();
+				break;
+			}
+			first = std::max(first, view.getIntactOldest(i) + getRenderSlack(i));
 		}
 	}
 }
 
+/*
+** isDecimated
+** Returns true if nPoints samples spanning the plot width are drawn as a
+** min/max envelope, one span per pixel column, rather than sample by sample.
+*/
+bool ofxScopePlot::isDecimated(double nPoints) {
+	float plotWidth = _max.x - _min.x;
+	if (plotWidth < 1) return false;
+	switch (_renderMode) {
+	case LINE:
+		return false;
+	case MIN_MAX:
+		return true;
+	case LTTB:
+		return nPoints > getLttbPoints();
+	default:
+		return nPoints > _decimationThreshold * plotWidth;
+	}
+}
+
+/*
+** getLttbPoints
+** Returns the number of samples LTTB reduces a variable to, proportional to
+** the plot width.
+*/
+size_t ofxScopePlot::getLttbPoints() {
+	return (size_t) std::max(OFX_SCOPE_LTTB_POINTS_PER_PIXEL * (_max.x - _min.x), 3.f);
+}
+
 /*
 ** getNumVariables
 ** Returns the number of variables in the current data buffer
 */
 int ofxScopePlot::getNumVariables() {
-	return _buffer.size();
+	return _buffer.getNumChannels();
 	//return _nVariables;
 }
 
@@ -423,11 +1185,263 @@ float ofxScopePlot::getSamplingFrequency() {
 	return _sampFreq;
 }
 
+/*
+** getSamplingFrequency
+** Returns the sampling frequency of variable i in Hz
+*/
+float ofxScopePlot::getSamplingFrequency(int i) {
+	if (i < _sampFreqs.size()) {
+		return _sampFreqs.at(i);
+	} else {
+		fprintf(stderr, "ERROR - getSamplingFrequency: uninitialized or invalid index");
+		return 0.f;
+	}
+}
+
+/*
+** setSampleFormat
+** Sets how the samples of variable i are stored. FLOAT16 and INT16 halve the
+** memory of long time windows; INT16 suits integer sources such as ADCs,
+** reading back as code * scale + offset. Held samples are converted.
+*/
+void ofxScopePlot::setSampleFormat(int i, const ofxScopeSampleFormat &format) {
+	if (i < 0 || i >= getNumVariables()) {
+		fprintf(stderr, "ERROR - setSampleFormat: uninitialized or invalid index");
+		return;
+	}
+	_buffer.setSampleFormat(i, format);
+	_vertexBuffers.at(i).invalidate();
+	_lttb.at(i).invalidate();
+	_strips.at(i).invalidate();
+	publish();
+}
+
+void ofxScopePlot::setSampleFormat(const ofxScopeSampleFormat &format) {
+	for (int i = 0; i < getNumVariables(); i++) {
+		setSampleFormat(i, format);
+	}
+}
+
+/*
+** getSampleFormat
+** Returns the storage format of variable i
+*/
+ofxScopeSampleFormat ofxScopePlot::getSampleFormat(int i) {
+	if (i < 0 || i >= getNumVariables()) {
+		fprintf(stderr, "ERROR - getSampleFormat: uninitialized or invalid index");
+		return ofxScopeSampleFormat();
+	}
+	return _buffer.getSampleFormat(i);
+}
+
+/*
+** getPointsPerWin
+** Returns the number of points of variable i in the time window
+*/
+int ofxScopePlot::getPointsPerWin(int i) {
+	return floor(_timeWindow * _sampFreqs.at(i));
+}
+
+/*
+** getRenderSlack
+** Returns how many samples of variable i the buffer holds beyond the time
+** window. Ingestion on another thread may run this far ahead of the frame
+** plot() is drawing before it overwrites samples still being drawn.
+*/
+size_t ofxScopePlot::getRenderSlack(int i) {
+	return ceil(OFX_SCOPE_RENDER_SLACK * _sampFreqs.at(i));
+}
+
+/*
+** publish
+** Makes the current buffer state the frame plot() draws next. Called after
+** every update; copies a few counters per variable, never the samples. Each
+** publish gets a new generation, which isDirty compares with the last plot.
+** After a freeze the first publish also copies the buffer for plot(), here
+** on the updating thread so the copy never races with writes.
+*/
+void ofxScopePlot::publish() {
+	_buffer.snapshot(_snapshots.back());
+	_snapshots.back().generation = ++_generation;
+	_snapshots.publish();
+
+	if (_frozen.load(std::memory_order_acquire)) {
+		uint64_t freeze = _freezeCount.load(std::memory_order_relaxed);
+		if (freeze != _copiedFreeze) {
+			std::shared_ptr<FrozenCopy> copy(new FrozenCopy());
+			copy->freeze = freeze;
+			copy->buffer = _buffer;
+			std::atomic_store(&_frozenCopy, std::shared_ptr<const FrozenCopy>(copy));
+			_copiedFreeze = freeze;
+		}
+	} else if (_copiedFreeze != 0) {
+		std::atomic_store(&_frozenCopy, std::shared_ptr<const FrozenCopy>());
+		_copiedFreeze = 0;
+	}
+}
+
+/*
+** getView
+** Returns a read-only view of the most recently published buffer state,
+** or of the state pinned by setFrozen. Until the updating thread has copied
+** the buffer for the freeze, the pinned state is read from the live buffer,
+** whose reads plot() validates like any other.
+*/
+ofxScopeView ofxScopePlot::getView() {
+	if (_frozen) {
+		if (!_frozenHeld) {
+			std::shared_ptr<const FrozenCopy> copy = std::atomic_load(&_frozenCopy);
+			if (copy && copy->freeze == _freezeCount) {
+				_frozenHeld = copy;
+			}
+		}
+		if (_frozenHeld) {
+			return ofxScopeView(_frozenHeld->buffer, _frozenSnapshot);
+		}
+		return ofxScopeView(_buffer, _frozenSnapshot);
+	}
+	return ofxScopeView(_buffer, _snapshots.latest());
+}
+
+/*
+** setFrozen
+** Freezing pins the most recently published state, so the display holds
+** still while updateData and drainQueue keep filling the buffer. The next
+** update copies the buffer for plot(), which keeps the copy alive for as
+** long as it plots it. Unfreezing drops the copy and plot() shows the newest
+** data straight away. Call from the thread that plots.
+*/
+void ofxScopePlot::setFrozen(bool frozen) {
+	if (frozen == _frozen) return;
+	_frozenHeld.reset();
+	if (frozen) {
+		_frozenSnapshot = _snapshots.latest();
+		_freezeCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	_frozen.store(frozen, std::memory_order_release);
+	_revision++;
+}
+
+bool ofxScopePlot::isFrozen() {
+	return _frozen;
+}
+
+/*
+** setVertexMode
+** Selects where the vertices of plotted samples are kept: GPU vertex buffer
+** objects, uploaded incrementally, or CPU memory streamed every frame for
+** software GL and headless runs. Defaults to GPU unless built with
+** OFX_SCOPE_CPU_VERTICES.
+*/
+void ofxScopePlot::setVertexMode(ofxScopeVertexBuffer::Mode mode) {
+	_vertexMode = mode;
+	_vertexBuffers.assign(_vertexBuffers.size(), ofxScopeVertexBuffer(_vertexMode));
+}
+
+ofxScopeVertexBuffer::Mode ofxScopePlot::getVertexMode() {
+	return _vertexMode;
+}
+
+/*
+** setRenderMode
+** Selects how samples are drawn. MIN_MAX buckets the samples of the time
+** window into pixel columns and draws the min-max span of each, so the cost
+** follows the plot width rather than the number of samples while keeping every
+** peak. LTTB instead keeps OFX_SCOPE_LTTB_POINTS_PER_PIXEL samples per column
+** chosen to preserve the shape, which suits smooth, slowly varying signals.
+** AUTO switches to MIN_MAX above the decimation threshold.
+*/
+void ofxScopePlot::setRenderMode(RenderMode renderMode) {
+	_renderMode = renderMode;
+	_revision++;
+}
+
+ofxScopePlot::RenderMode ofxScopePlot::getRenderMode() {
+	return _renderMode;
+}
+
+/*
+** setDecimationThreshold
+** Sets the number of samples per pixel column above which AUTO draws the
+** min/max envelope. Defaults to OFX_SCOPE_DECIMATION_THRESHOLD.
+*/
+void ofxScopePlot::setDecimationThreshold(float samplesPerPixel) {
+	_decimationThreshold = std::max(samplesPerPixel, 1.f);
+	_revision++;
+}
+
+float ofxScopePlot::getDecimationThreshold() {
+	return _decimationThreshold;
+}
+
+/*
+** setScrollingStrip
+** Keeps each variable's trace rasterized in an offscreen strip that scrolls
+** with the samples (see ofxScopeStrip). Each frame draws only the samples
+** appended since the previous one and composites the strip, so the cost
+** follows the ingest rate rather than the time window. Autoscaling stretches
+** the strip rather than redrawing it. Uses one texture per variable the width
+** and twice the height of the plot. LTTB and timestamped plots are drawn
+** directly.
+*/
+void ofxScopePlot::setScrollingStrip(bool scrollingStrip) {
+	_scrollingStrip = scrollingStrip;
+	for (int i = 0; i < _strips.size(); i++) {
+		_strips.at(i).invalidate();
+	}
+	_revision++;
+}
+
+bool ofxScopePlot::isScrollingStrip() {
+	return _scrollingStrip;
+}
+
+/*
+** isDirty
+** Returns true if plotTraces would draw something other than it did last
+** time: new data was published or queued, a setter changed how the data is
+** drawn, or the window height changed. A scope that is not dirty may reuse its
+** last rendered output. Call from the thread that plots.
+*/
+bool ofxScopePlot::isDirty() {
+	return !_plotted || _queue.size() > 0
+		|| getView().getGeneration() != _plottedGeneration
+		|| _revision != _plottedRevision
+		|| ofGetWindowHeight() != _plottedWindowHeight;
+}
+
+/*
+** getGeneration
+** Returns the generation of the data plotTraces would draw. It changes with
+** every update, clearData and sample format change; it holds still while
+** frozen.
+*/
+uint64_t ofxScopePlot::getGeneration() {
+	return getView().getGeneration();
+}
+
+uint64_t ofxScopePlot::getRevision() {
+	return _revision;
+}
+
 
 /*-------------------------------------------------
 * ofxOscilloscope
 * Class to create an oscilloscope panel
 *-------------------------------------------------*/
+
+/*
+** addRect
+** Appends the rectangle [x0, x1] x [y0, y1] in one color to a triangle mesh.
+*/
+static void addRect(ofMesh &mesh, float x0, float y0, float x1, float y1, const ofColor &color) {
+	ofPoint corners[6] = { ofPoint(x0, y0), ofPoint(x1, y0), ofPoint(x1, y1),
+		ofPoint(x0, y0), ofPoint(x1, y1), ofPoint(x0, y1) };
+	for (int c = 0; c < 6; c++) {
+		mesh.addVertex(corners[c]);
+		mesh.addColor(color);
+	}
+}
 /*
 ofxOscilloscope::ofxOscilloscope() {
 	_variableNames = NULL;
@@ -474,6 +1488,12 @@ ofxOscilloscope::ofxOscilloscope(ofRectangle scopeArea, ofTrueTypeFont legendFon
 	_textSpacer = 20;
 	_autoscaleY = false;
 	_minYSpan = 0.f;
+	_autoscaleHysteresis = 0.f;
+	_autoscaleLims = pair<float, float>(0.f, 0.f);
+	_chromeDirty = true;
+	_outputCached = false;
+	_panelDirty = true;
+	_labelsDirty = true;
 }
 
 ofxOscilloscope::ofxOscilloscope(ofPoint min, ofPoint max, ofTrueTypeFont legendFont,
@@ -507,6 +1527,12 @@ ofxOscilloscope::ofxOscilloscope(ofPoint min, ofPoint max, ofTrueTypeFont legend
 	_textSpacer = 20;
 	_autoscaleY = false;
 	_minYSpan = 0.f;
+	_autoscaleHysteresis = 0.f;
+	_autoscaleLims = pair<float, float>(0.f, 0.f);
+	_chromeDirty = true;
+	_outputCached = false;
+	_panelDirty = true;
+	_labelsDirty = true;
 }
 
 /*
@@ -550,6 +1576,31 @@ void ofxOscilloscope::setup(float timeWindow, float sampFreq,
 	std::vector<string> variableNames, std::vector<ofColor> variableColors,
 	float yScale, float yOffset) {
 
+	setup(timeWindow, std::vector<float>(variableNames.size(), sampFreq),
+		variableNames, variableColors,
+		yScale, yOffset);
+}
+
+/*
+** setup
+** Initializes the oscilloscope with a separate sampling frequency per variable.
+** All variables are plotted on the same time axis.
+** 
+** INPUT:
+** timeWindow		Specifies the time in seconds of the oscilloscope window
+** sampFreqs		Specifies the sampling frequency of each variable
+** variableNames	Display names for variables
+** variableColors	Display colors of variables
+** yScale			Muliplier for Y scaling axis
+** yOffset			Offset for the Y axis
+**
+** REMARKS:
+** sampFreqs, variableNames and variableColors must be the same size.
+*/
+void ofxOscilloscope::setup(float timeWindow, std::vector<float> sampFreqs,
+	std::vector<string> variableNames, std::vector<ofColor> variableColors,
+	float yScale, float yOffset) {
+
 	//if (variableNames.size() > variableColors.size()) {
 	//	fprintf(stderr, "ERROR: variableNames.size() > variableColors.size()");
 	if (variableNames.size() > variableColors.size()) {
@@ -566,8 +1617,9 @@ void ofxOscilloscope::setup(float timeWindow, float sampFreq,
 	ofPoint min = _min;
 	min.x = min.x + _legendWidth;
 
-	_scopePlot.setup(timeWindow, sampFreq, variableColors, yScale, yOffset);
+	_scopePlot.setup(timeWindow, sampFreqs, variableColors, yScale, yOffset);
 	setVariableNames(variableNames);
+	_chromeDirty = true;
 }
 
 /*
@@ -607,6 +1659,7 @@ void ofxOscilloscope::setVariableNames(std::vector<string> variableNames) {
 		fprintf(stderr, "ERROR: variableNames.size() != getNumVariables()");
 	} else {
 		_variableNames = variableNames;
+		_chromeDirty = true;
 	}
 }
 
@@ -627,6 +1680,7 @@ void ofxOscilloscope::setVariableNames(string variableNames[], int nVariables) {
 */
 void ofxOscilloscope::setVariableColors(std::vector<ofColor> colors){
 	_scopePlot.setVariableColors(colors);
+	_chromeDirty = true;
 }
 
 /*
@@ -654,6 +1708,7 @@ void ofxOscilloscope::setPlotLineWidth(float plotLineWidth) {
 */
 void ofxOscilloscope::setOutlineWidth(float outlineWidth) {
 	_outlineWidth = outlineWidth;
+	_chromeDirty = true;	// The zero line shares the outline width
 }
 
 /*
@@ -662,6 +1717,7 @@ void ofxOscilloscope::setOutlineWidth(float outlineWidth) {
 */
 void ofxOscilloscope::setOutlineColor(ofColor outlineColor) {
 	_outlineColor = outlineColor;
+	_panelDirty = true;	// The axes labels are drawn in the outline color
 }
 
 /*
@@ -670,6 +1726,7 @@ void ofxOscilloscope::setOutlineColor(ofColor outlineColor) {
 */
 void ofxOscilloscope::setZeroLineColor(ofColor zeroLineColor) {
 	_scopePlot.setZeroLineColor(zeroLineColor);
+	_chromeDirty = true;
 }
 
 /*
@@ -679,6 +1736,7 @@ void ofxOscilloscope::setZeroLineColor(ofColor zeroLineColor) {
 void ofxOscilloscope::setBackgroundColor(ofColor backgroundColor) {
 	_backgroundColor = backgroundColor;
 	_scopePlot.setBackgroundColor(backgroundColor);
+	_chromeDirty = true;
 }
 
 /*
@@ -687,6 +1745,7 @@ void ofxOscilloscope::setBackgroundColor(ofColor backgroundColor) {
 */ 
 void ofxOscilloscope::setLegendFont(ofTrueTypeFont legendFont) {
 	_legendFont = legendFont;
+	_chromeDirty = true;
 }
 
 /*
@@ -695,6 +1754,8 @@ void ofxOscilloscope::setLegendFont(ofTrueTypeFont legendFont) {
 */
 void ofxOscilloscope::setAxesFont(ofTrueTypeFont axesFont) {
 	_axesFont = axesFont;
+	_panelDirty = true;
+	_labelsDirty = true;
 }
 
 /*
@@ -715,6 +1776,7 @@ void ofxOscilloscope::setLegendWidth(int legendWidth) {
 void ofxOscilloscope::setTextSpacing(int legendPadding, int textSpacing) {
 	_legendPadding = legendPadding;
 	_textSpacer = textSpacing;
+	_chromeDirty = true;
 }
 
 /*
@@ -728,6 +1790,7 @@ void ofxOscilloscope::setPosition(ofPoint min, ofPoint max) {
 	// reposition the scopePlot
 	min.x = min.x + _legendWidth;
 	_scopePlot.setPosition(min, max);
+	_chromeDirty = true;
 }
 void  ofxOscilloscope::setPosition(ofRectangle scopeArea) {
 	setPosition(scopeArea.getTopLeft(), scopeArea.getBottomRight());
@@ -750,6 +1813,14 @@ float ofxOscilloscope::getSamplingFrequency() {
 	return _scopePlot.getSamplingFrequency();
 }
 
+/*
+** getSamplingFrequency
+** Returns the sampling frequency of variable i
+*/
+float ofxOscilloscope::getSamplingFrequency(int i) {
+	return _scopePlot.getSamplingFrequency(i);
+}
+
 /*
 ** setTimeWindow
 ** Sets the timeWindow covered by the scope.
@@ -766,6 +1837,134 @@ float ofxOscilloscope::getTimeWindow() {
 	return _scopePlot.getTimeWindow();
 }
 
+/*
+** setRetention
+** Sets how many seconds of data the scope keeps so that changing the
+** timeWindow (e.g. incrementTimeWindow) up to it keeps all data.
+*/
+void ofxOscilloscope::setRetention(float retention) {
+	_scopePlot.setRetention(retention);
+}
+
+float ofxOscilloscope::getRetention() {
+	return _scopePlot.getRetention();
+}
+
+/*
+** setupHistory
+** Keeps seconds of data in memory-mapped files in directory so the scope
+** can zoom out and scroll back far beyond its retention.
+*/
+void ofxOscilloscope::setupHistory(string directory, float seconds) {
+	_scopePlot.setupHistory(directory, seconds);
+}
+
+/*
+** setupCompressedHistory
+** Keeps seconds of data compressed in memory so the scope can zoom out and
+** scroll back far beyond its retention without touching the disk.
+*/
+void ofxOscilloscope::setupCompressedHistory(float seconds) {
+	_scopePlot.setupCompressedHistory(seconds);
+}
+
+void ofxOscilloscope::setScrollOffset(float seconds) {
+	_scopePlot.setScrollOffset(seconds);
+}
+
+float ofxOscilloscope::getScrollOffset() {
+	return _scopePlot.getScrollOffset();
+}
+
+/*
+** setSampleFormat
+** Sets how the samples of all variables, or of variable i, are stored.
+** See ofxScopeSampleFormat.
+*/
+void ofxOscilloscope::setSampleFormat(const ofxScopeSampleFormat &format) {
+	_scopePlot.setSampleFormat(format);
+}
+
+void ofxOscilloscope::setSampleFormat(int i, const ofxScopeSampleFormat &format) {
+	_scopePlot.setSampleFormat(i, format);
+}
+
+ofxScopeSampleFormat ofxOscilloscope::getSampleFormat(int i) {
+	return _scopePlot.getSampleFormat(i);
+}
+
+/*
+** setFrozen
+** Holds the displayed data while updates keep filling the buffer; plotting
+** catches up with the buffer as soon as the scope is unfrozen.
+*/
+void ofxOscilloscope::setFrozen(bool frozen) {
+	_scopePlot.setFrozen(frozen);
+}
+
+bool ofxOscilloscope::isFrozen() {
+	return _scopePlot.isFrozen();
+}
+
+void ofxOscilloscope::setVertexMode(ofxScopeVertexBuffer::Mode mode) {
+	_scopePlot.setVertexMode(mode);
+}
+
+ofxScopeVertexBuffer::Mode ofxOscilloscope::getVertexMode() {
+	return _scopePlot.getVertexMode();
+}
+
+void ofxOscilloscope::setRenderMode(ofxScopePlot::RenderMode renderMode) {
+	_scopePlot.setRenderMode(renderMode);
+}
+
+ofxScopePlot::RenderMode ofxOscilloscope::getRenderMode() {
+	return _scopePlot.getRenderMode();
+}
+
+void ofxOscilloscope::setDecimationThreshold(float samplesPerPixel) {
+	_scopePlot.setDecimationThreshold(samplesPerPixel);
+}
+
+float ofxOscilloscope::getDecimationThreshold() {
+	return _scopePlot.getDecimationThreshold();
+}
+
+void ofxOscilloscope::setScrollingStrip(bool scrollingStrip) {
+	_scopePlot.setScrollingStrip(scrollingStrip);
+}
+
+bool ofxOscilloscope::isScrollingStrip() {
+	return _scopePlot.isScrollingStrip();
+}
+
+/*
+** setOutputCached
+** Renders the panel into an offscreen buffer and draws that buffer again as
+** long as isDirty() is false, so scopes whose streams are silent cost one
+** textured quad per frame. Uses one RGBA texture the size of the panel.
+*/
+void ofxOscilloscope::setOutputCached(bool outputCached) {
+	_outputCached = outputCached;
+	if (!_outputCached) {
+		_output.clear();
+	}
+	_panelDirty = true;
+}
+
+bool ofxOscilloscope::isOutputCached() {
+	return _outputCached;
+}
+
+/*
+** isDirty
+** Returns true if plot() would draw something other than last time: new
+** data, a changed setting of the panel or its plot, or a resized window.
+*/
+bool ofxOscilloscope::isDirty() {
+	return _panelDirty || _chromeDirty || _scopePlot.isDirty();
+}
+
 /*
 ** setYScale
 ** Sets the yScale of the data in the oscilloscope window.
@@ -801,10 +2000,18 @@ float ofxOscilloscope::getYOffset() {
 /*
 ** autoscaleY
 ** sets the autoscaling of the oscilloscope Y-axis
+**
+** minYSpan		Smallest span of the Y-axis
+** hysteresis	Fraction of the current span by which the data range must
+**				shrink before the Y-axis zooms in again. The Y-axis always
+**				grows immediately to fit the data. 0 rescales on every change.
 */
-void ofxOscilloscope::autoscaleY(bool autoscale, float minYSpan) {
+void ofxOscilloscope::autoscaleY(bool autoscale, float minYSpan, float hysteresis) {
 	_autoscaleY = autoscale;
 	_minYSpan = minYSpan;
+	_autoscaleHysteresis = hysteresis;
+	_panelDirty = true;
+	_autoscaleLims = pair<float, float>(0.f, 0.f);
 }
 
 float ofxOscilloscope::getMinYSpan() {
@@ -896,69 +2103,121 @@ float ofxOscilloscope::decrementTimeWindow() {
 /*
 ** updateData
 **
-** Data should come in the form data[nVariables] with one data point/variable
-** or in form data[nDataPoints] iff scope is setup with variableNames.size() == 1
+** Data should come in the form data[nVariables] with one data point/variable
+** or in form data[nDataPoints] iff scope is setup with variableNames.size() == 1
+**
+** Loads new data onto the oscillocope buffer. Must have the same number
+** of variables initialized with setup. plot() may be called to display the 
+** updated buffer.
+*/
+void ofxOscilloscope::updateData(const std::vector<float> &data) {
+#ifdef DEBUG_PRINT
+	printf("ofxOscilloscope::updateData\n"); 
+#endif
+	if (_variableNames.size() > 1)
+	{
+		_scopePlot.updateData(data);
+	}
+	else
+	{
+		// Treat data as nPoints of the single data stream
+		_scopePlot.updateData(0, data.data(), data.size());
+	}
+}
+
+/*
+** updateData
+**
+** Data should come in the form[nVariables][nDataPoints]
+**
+** Loads new data onto the oscillocope buffer. Must have the same number
+** of variables initialized with setup. plot() may be called to display the 
+** updated buffer.
+*/
+void ofxOscilloscope::updateData(const std::vector<std::vector<float> > &data) {
+#ifdef DEBUG_PRINT
+	printf("ofxOscilloscope::updateData\n"); 
+#endif
+	_scopePlot.updateData(data);
+}
+
+
+/*
+** updateData
+**
+** Data should come in the form [nDataPoints]
+**
+** Loads new data onto the oscillocope buffer. Must have the same number
+** of variables initialized with setup. plot() may be called to display the
+** updated buffer.
+*/
+void ofxOscilloscope::updateData(size_t variableNum, const std::vector<float> &data) {
+#ifdef DEBUG_PRINT
+	printf("ofxOscilloscope::updateData\n");
+#endif
+	size_t numVars = _scopePlot.getNumVariables();
+	if (variableNum < numVars)
+	{
+		_scopePlot.updateData(variableNum, data.data(), data.size());
+	}
+}
+
+/*
+** updateData
+**
+** Data should come in the form data[nDataPoints * stride]
+**
+** Copies the data straight from the caller's memory onto the oscilloscope
+** buffer of a single variable, without intermediate vectors.
+*/
+void ofxOscilloscope::updateData(size_t variableNum, const float * data, size_t nPoints, size_t stride) {
+#ifdef DEBUG_PRINT
+	printf("ofxOscilloscope::updateData\n");
+#endif
+	_scopePlot.updateData(variableNum, data, nPoints, stride);
+}
+
+/*
+** updateData
+**
+** Data should come in the form codes[nDataPoints * stride]
 **
-** Loads new data onto the oscillocope buffer. Must have the same number
-** of variables initialized with setup. plot() may be called to display the 
-** updated buffer.
+** Copies raw integer samples onto the buffer of a single variable; a variable
+** stored as ofxScopeSampleFormat::INT16 keeps them unconverted.
 */
-void ofxOscilloscope::updateData(std::vector<float> data) {
+void ofxOscilloscope::updateData(size_t variableNum, const int16_t * codes, size_t nPoints, size_t stride) {
 #ifdef DEBUG_PRINT
-	printf("ofxOscilloscope::updateData\n"); 
+	printf("ofxOscilloscope::updateData\n");
 #endif
-	if (_variableNames.size() > 1)
-	{
-		_scopePlot.updateData(data);
-	}
-	else
-	{
-		// Reshape data to easily handle case where we're plotting a single data stream
-		vector<vector<float>> temp;
-		temp.resize(1);
-		temp.at(0) = data;
-		_scopePlot.updateData(temp);
-	}
+	_scopePlot.updateData(variableNum, codes, nPoints, stride);
 }
 
 /*
 ** updateData
 **
-** Data should come in the form[nVariables][nDataPoints]
+** Data should come in the form data[nDataPoints]
 **
-** Loads new data onto the oscillocope buffer. Must have the same number
-** of variables initialized with setup. plot() may be called to display the 
-** updated buffer.
+** Loads a view of caller memory onto the buffer of a single variable.
 */
-void ofxOscilloscope::updateData(std::vector<std::vector<float> > data) {
+void ofxOscilloscope::updateData(size_t variableNum, ofxScopeSpan data) {
 #ifdef DEBUG_PRINT
-	printf("ofxOscilloscope::updateData\n"); 
+	printf("ofxOscilloscope::updateData\n");
 #endif
-	_scopePlot.updateData(data);
+	_scopePlot.updateData(variableNum, data);
 }
 
-
 /*
 ** updateData
 **
-** Data should come in the form [nDataPoints]
+** Data should come in the form data[nVariables][nDataPoints]
 **
-** Loads new data onto the oscillocope buffer. Must have the same number
-** of variables initialized with setup. plot() may be called to display the
-** updated buffer.
+** Loads one view of caller memory per variable onto the oscilloscope buffer.
 */
-void ofxOscilloscope::updateData(size_t variableNum, std::vector<float> data) {
+void ofxOscilloscope::updateData(const ofxScopeSpan data[], int nVariables) {
 #ifdef DEBUG_PRINT
 	printf("ofxOscilloscope::updateData\n");
 #endif
-	size_t numVars = _scopePlot.getNumVariables();
-	if (variableNum < numVars)
-	{
-		std::vector<std::vector<float>> multiData;
-		multiData.resize(numVars);
-		multiData.at(variableNum) = data;
-		_scopePlot.updateData(multiData);
-	}
+	_scopePlot.updateData(data, nVariables);
 }
 
 
@@ -980,23 +2239,191 @@ void ofxOscilloscope::updateData(float ** data, int nPoints) {
 	_scopePlot.updateData(data, nPoints);
 }
 
+/*
+** updateDataInterleaved
+**
+** Data should come in the form frames[nFrames][nVariables]
+**
+** Deinterleaves frame-major data directly onto the oscilloscope buffer.
+** Returns false without writing anything if nVariables doesn't match setup.
+*/
+bool ofxOscilloscope::updateDataInterleaved(const float * frames, size_t nFrames, int nVariables) {
+#ifdef DEBUG_PRINT
+	printf("ofxOscilloscope::updateDataInterleaved\n"); 
+#endif
+	return _scopePlot.updateDataInterleaved(frames, nFrames, nVariables);
+}
+
+bool ofxOscilloscope::updateDataInterleaved(const std::vector<float> &frames, int nVariables) {
+#ifdef DEBUG_PRINT
+	printf("ofxOscilloscope::updateDataInterleaved\n"); 
+#endif
+	return _scopePlot.updateDataInterleaved(frames, nVariables);
+}
+
+/*
+** updateData
+**
+** Data should come in the form data[nVariables] with one data point/variable,
+** all sampled at timestamp (seconds). Requires setTimestamped(true).
+*/
+void ofxOscilloscope::updateData(const std::vector<float> &data, double timestamp) {
+#ifdef DEBUG_PRINT
+	printf("ofxOscilloscope::updateData\n");
+#endif
+	_scopePlot.updateData(data, timestamp);
+}
+
+/*
+** updateData
+**
+** Data should come in the form data[nDataPoints * stride] with
+** timestamps[nDataPoints] in seconds. Requires setTimestamped(true).
+*/
+void ofxOscilloscope::updateData(size_t variableNum, const float * data, const double * timestamps,
+	size_t nPoints, size_t stride) {
+#ifdef DEBUG_PRINT
+	printf("ofxOscilloscope::updateData\n");
+#endif
+	_scopePlot.updateData(variableNum, data, timestamps, nPoints, stride);
+}
+
+/*
+** setTimestamped
+** Positions samples on the x-axis by their timestamps. Must be called after setup.
+*/
+void ofxOscilloscope::setTimestamped(bool timestamped) {
+	_scopePlot.setTimestamped(timestamped);
+}
+
+bool ofxOscilloscope::isTimestamped() {
+	return _scopePlot.isTimestamped();
+}
+
 void ofxOscilloscope::clearData() {
 	_scopePlot.clearData();
 }
 
+/*
+** setupQueue
+** Lets one acquisition thread push frames with pushData while the main
+** thread plots. See ofxScopePlot::setupQueue.
+*/
+void ofxOscilloscope::setupQueue(size_t capacity) {
+	_scopePlot.setupQueue(capacity);
+}
+
+bool ofxOscilloscope::pushData(const float * frame) {
+	return _scopePlot.pushData(frame);
+}
+
+bool ofxOscilloscope::pushData(const std::vector<float> &data) {
+	return _scopePlot.pushData(data);
+}
+
+bool ofxOscilloscope::pushData(const std::vector<float> &data, double timestamp) {
+	return _scopePlot.pushData(data, timestamp);
+}
+
+size_t ofxOscilloscope::pushDataInterleaved(const float * frames, size_t nFrames) {
+	return _scopePlot.pushDataInterleaved(frames, nFrames);
+}
+
+size_t ofxOscilloscope::drainQueue() {
+	return _scopePlot.drainQueue();
+}
+
+uint64_t ofxOscilloscope::getOverruns() {
+	return _scopePlot.getOverruns();
+}
+
+uint64_t ofxOscilloscope::resetOverruns() {
+	return _scopePlot.resetOverruns();
+}
+
 /*
 ** plot
-** Plots the data in the buffer
+** Plots the data in the buffer. With setOutputCached, a scope that is not
+** dirty draws its last rendered panel instead.
 */
 void ofxOscilloscope::plot(){
 
+	// Bring in queued frames before autoscaling
+	drainQueue();
+
 	ofPushStyle();
 
-	// Legend Background
+	if (_outputCached) {
+		plotCached();
+	} else {
+		plotPanel();
+	}
+
+	ofSetColor(_outlineColor);
+	ofSetLineWidth(_outlineWidth);
+
 	ofEnableAlphaBlending();
-	ofSetColor(_backgroundColor);
-	ofPoint legendMax = ofPoint(_min.x + _legendWidth, _max.y);
-	ofRect(ofRectangle(_min, legendMax));
+	_chromeOutline.draw();
+	ofDisableAlphaBlending(); 
+
+	ofPopStyle();
+}
+
+/*
+** plotCached
+** Draws the panel from _output, rendering it again only if the scope is dirty.
+** The panel is rendered over transparent black; OF's alpha blending mode
+** blends alpha with (1, 1 - srcAlpha), so _output holds premultiplied colors
+** and is composited with (1, 1 - srcAlpha) to match drawing directly. The
+** outlines straddle the panel edges and are drawn by plot() in any case.
+*/
+void ofxOscilloscope::plotCached() {
+	int width = (int) ceil(_max.x - _min.x);
+	int height = (int) ceil(_max.y - _min.y);
+	if (width <= 0 || height <= 0) return;
+	if (!_output.isAllocated() || _output.getWidth() != width || _output.getHeight() != height) {
+		_output.allocate(width, height, GL_RGBA);
+		_panelDirty = true;
+	}
+
+	if (isDirty()) {
+		_output.begin();
+		ofClear(0, 0, 0, 0);
+		ofPushMatrix();
+		ofTranslate(-_min.x, -_min.y);
+		plotPanel();
+		ofPopMatrix();
+		_output.end();
+	}
+
+	ofEnableAlphaBlending();
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	ofSetColor(255, 255, 255, 255);
+	_output.draw(_min.x, _min.y);
+	ofDisableAlphaBlending();
+}
+
+/*
+** plotPanel
+** Draws the backgrounds, legend, axes labels and data; everything but the
+** outlines.
+*/
+void ofxOscilloscope::plotPanel() {
+	_panelDirty = false;
+
+	// Backgrounds, zero line and legend text come from the cached chrome
+	if (_chromeDirty) {
+		buildChrome();
+		_chromeDirty = false;
+		_labelsDirty = true;	// Labels are placed relative to the panel
+	}
+	ofEnableAlphaBlending();
+	_chromeFill.draw();
+	if (_legendText.getNumVertices() > 0) {
+		_legendFont.getFontTexture().bind();
+		_legendText.draw();
+		_legendFont.getFontTexture().unbind();
+	}
 	ofDisableAlphaBlending(); 
 
 	ofSetColor(_outlineColor);
@@ -1012,118 +2439,167 @@ void ofxOscilloscope::plot(){
 		ySpan = minMaxY.second - minMaxY.first;
 		meanXY = (minMaxY.first + minMaxY.second) / 2;
 
-		// Using ofGetWindowHeight() here is messy
-		// ToDo: Consider refactoring code to make use ofScale() and ofTranslate() instead multiplication and subtraction
-		float yScale = ofGetWindowHeight() / (ySpan);
-		float yOffset = - meanXY * yScale;
-		//float yOffset = 0;
-		_scopePlot.setYOffset(yOffset);
-		_scopePlot.setYScale(yScale);
+		// Only rescale when the data leaves the current limits or shrinks
+		// by more than the hysteresis, so the axes don't re-layout every frame
+		float limsSpan = _autoscaleLims.second - _autoscaleLims.first;
+		bool outside = minMaxY.first < _autoscaleLims.first || minMaxY.second > _autoscaleLims.second;
+		bool shrunk = (limsSpan - ySpan) > _autoscaleHysteresis * limsSpan;
+		if ((_autoscaleHysteresis <= 0.f || outside || shrunk) && ySpan > 0) {
+			_autoscaleLims = minMaxY;
+
+			// Using ofGetWindowHeight() here is messy
+			// ToDo: Consider refactoring code to make use ofScale() and ofTranslate() instead multiplication and subtraction
+			float yScale = ofGetWindowHeight() / (ySpan);
+			float yOffset = - meanXY * yScale;
+			//float yOffset = 0;
+			_scopePlot.setYOffset(yOffset);
+			_scopePlot.setYScale(yScale);
+		}
 	}
 
-	// Timescale
-	string axesString = ofToString(_scopePlot.getTimeWindow()) + " sec," + " yScale=" + ofToString(getYScale())
-		+ ", yOffset=" + ofToString(getYOffset(), 1);
-	float legendX = _min.x + _legendWidth + _legendPadding;
-	float legendY = _max.y - _legendPadding;
-	float yLabelPadding = 3;
-	float yValX = _min.x + _legendWidth - yLabelPadding;
-	float yValY = (_min.y + _max.y) / 2;
-
-	if (_axesFont.isLoaded())
-	{
-		_axesFont.drawString(axesString, legendX, legendY);
-	}
-	else
-	{
-		ofDrawBitmapString(axesString, legendX, legendY);
+	// Axes labels come from the cache, rebuilt when the values they show change
+	if (_labelsDirty || _labelTimeWindow != _scopePlot.getTimeWindow() || _labelYScale != getYScale()
+		|| _labelYOffset != getYOffset() || _labelWindowHeight != ofGetWindowHeight()) {
+		buildAxesLabels();
+		_labelsDirty = false;
 	}
-
-	
-	string yVal;
-	ofRectangle yValBox; 
-
 	if (_axesFont.isLoaded()) {
-
-		yVal = ofToString(-getYOffset() / getYScale());
-		yValBox = _axesFont.getStringBoundingBox(yVal, 0, 0);
-		_axesFont.drawString(yVal, yValX - yValBox.getRight(), yValY + _axesFont.getAscenderHeight() / 2);
-
-		yVal = ofToString((-getYOffset() + ofGetWindowHeight() / 2) / getYScale());
-		yValBox = _axesFont.getStringBoundingBox(yVal, 0, 0);
-		_axesFont.drawString(yVal, yValX - yValBox.getRight(), _min.y - yValBox.getTop() + yLabelPadding);
-
-		yVal = ofToString((-getYOffset() - ofGetWindowHeight() / 2) / getYScale());
-		yValBox = _axesFont.getStringBoundingBox(yVal, 0, 0);
-		_axesFont.drawString(yVal, yValX - yValBox.getRight(), _max.y - yLabelPadding);
-
-	}
-	else
-	{
-		ofBitmapFont bitmapFont;
-		yVal = ofToString(-getYOffset() / getYScale());
-        yValBox = bitmapFont.getBoundingBox(yVal,0,0);
-        ofDrawBitmapString(yVal, yValX - yValBox.getRight(), yValY + yValBox.getHeight() / 2);
-        
-        yVal = ofToString((-getYOffset() + ofGetWindowHeight() / 2) / getYScale());
-        yValBox = bitmapFont.getBoundingBox(yVal,0,0);
-        ofDrawBitmapString(yVal, yValX - yValBox.getRight(), _min.y - yValBox.getTop() + yLabelPadding);
-        
-        yVal = ofToString((-getYOffset() - ofGetWindowHeight() / 2) / getYScale());
-        yValBox = bitmapFont.getBoundingBox(yVal,0,0);
-        ofDrawBitmapString(yVal,  yValX - yValBox.getRight(), _max.y - yLabelPadding);
+		ofEnableAlphaBlending();
+		_axesFont.getFontTexture().bind();
+		_axesText.draw();
+		_axesFont.getFontTexture().unbind();
+		ofDisableAlphaBlending();
+	} else {
+		for (size_t l = 0; l < _axesLabels.size(); l++) {
+			ofDrawBitmapString(_axesLabels.at(l), _axesLabelPositions.at(l).x, _axesLabelPositions.at(l).y);
+		}
 	}
 
+	// Legend Text without a loaded font is not cached
+	if (_legendWidth >= 0 && !_legendFont.isLoaded()) {
+		for (int i=0; i<_scopePlot.getNumVariables(); i++) {
+			ofSetColor(_scopePlot.getVariableColor(i));
+			ofDrawBitmapString(getVariableName(i), _min.x + _legendPadding, _min.y + _legendPadding + _textSpacer*(i + 1));
+		}
+	}
 
+	// Plot the Data
+	_scopePlot.plotTraces();
+}
 
-	for (int i=0; i<_scopePlot.getNumVariables(); i++) {
-		// Legend Text
-		if (_legendWidth >= 0)
-		{
-			ofSetColor(_scopePlot.getVariableColor(i));
-			string legendString = getVariableName(i);
-			float legendX = _min.x + _legendPadding;
-			float legendY = _min.y + _legendPadding + _textSpacer*(i + 1);
-			if (_legendFont.isLoaded())
-			{
-				_legendFont.drawString(legendString, legendX, legendY);
-			}
-			else
-			{
-				ofDrawBitmapString(legendString, legendX, legendY);
+/*
+** buildChrome
+** Rebuilds the meshes of the parts of the panel that only change through
+** setters: the legend and plot backgrounds, the zero line, the legend text and
+** the outlines. plot() then draws them with a few calls per frame.
+*/
+void ofxOscilloscope::buildChrome() {
+	ofRectangle plotArea = _scopePlot.getPosition();
+	float zeroY = plotArea.getY() + plotArea.getHeight() / 2;
+
+	_chromeFill.clear();
+	_chromeFill.setMode(OF_PRIMITIVE_TRIANGLES);
+	addRect(_chromeFill, _min.x, _min.y, _min.x + _legendWidth, _max.y, _backgroundColor);
+	addRect(_chromeFill, plotArea.getX(), plotArea.getY(),
+		plotArea.getX() + plotArea.getWidth(), plotArea.getY() + plotArea.getHeight(), _scopePlot.getBackgroundColor());
+	// The zero line as a quad, _outlineWidth thick
+	addRect(_chromeFill, plotArea.getX(), zeroY - _outlineWidth / 2,
+		plotArea.getX() + plotArea.getWidth(), zeroY + _outlineWidth / 2, _scopePlot.getZeroLineColor());
+
+	_legendText.clear();
+	_legendText.setMode(OF_PRIMITIVE_TRIANGLES);
+	if (_legendWidth >= 0 && _legendFont.isLoaded()) {
+		for (int i=0; i<_scopePlot.getNumVariables(); i++) {
+			size_t nVertices = _legendText.getNumVertices();
+			_legendText.append(_legendFont.getStringMesh(getVariableName(i),
+				_min.x + _legendPadding, _min.y + _legendPadding + _textSpacer*(i + 1), ofIsVFlipped()));
+			for (size_t v = nVertices; v < _legendText.getNumVertices(); v++) {
+				_legendText.addColor(_scopePlot.getVariableColor(i));
 			}
 		}
-	}	
+	}
 
-	// Sets the zero line width when called before plot()
-	ofSetLineWidth(_outlineWidth);
+	_chromeOutline.clear();
+	_chromeOutline.setMode(OF_PRIMITIVE_LINES);
+	std::vector<ofPoint> corners;
+	if (_legendWidth >= 0) {
+		// Legend outline
+		corners.push_back(ofPoint(_min.x, _min.y));
+		corners.push_back(ofPoint(_min.x, _max.y));
+		corners.push_back(ofPoint(_min.x, _max.y));
+		corners.push_back(ofPoint(_min.x + _legendWidth, _max.y));
+		corners.push_back(ofPoint(_min.x + _legendWidth, _max.y));
+		corners.push_back(ofPoint(_min.x + _legendWidth, _min.y));
+		corners.push_back(ofPoint(_min.x + _legendWidth, _min.y));
+		corners.push_back(ofPoint(_min.x, _min.y));
+	}
+	// Scope outline
+	corners.push_back(ofPoint(_min.x + _legendWidth, _max.y));
+	corners.push_back(ofPoint(_max.x, _max.y));
+	corners.push_back(ofPoint(_max.x, _max.y));
+	corners.push_back(ofPoint(_max.x, _min.y));
+	corners.push_back(ofPoint(_max.x, _min.y));
+	corners.push_back(ofPoint(_min.x + _legendWidth, _min.y));
+	for (size_t c = 0; c < corners.size(); c++) {
+		_chromeOutline.addVertex(corners[c]);
+	}
+}
 
-	// Plot the Data
-	_scopePlot.plot();
+/*
+** buildAxesLabels
+** Formats the time window and y-axis labels for the current values and
+** places them, measuring each once. With an axes font loaded the glyphs go
+** into one mesh drawn with the font texture; otherwise plot() draws the
+** strings as bitmap text.
+*/
+void ofxOscilloscope::buildAxesLabels() {
+	_labelTimeWindow = _scopePlot.getTimeWindow();
+	_labelYScale = getYScale();
+	_labelYOffset = getYOffset();
+	_labelWindowHeight = ofGetWindowHeight();
 
-	ofSetColor(_outlineColor);
-	ofSetLineWidth(_outlineWidth);
+	float legendX = _min.x + _legendWidth + _legendPadding;
+	float legendY = _max.y - _legendPadding;
+	float yLabelPadding = 3;
+	float yValX = _min.x + _legendWidth - yLabelPadding;
+	float yValY = (_min.y + _max.y) / 2;
 
-	ofEnableAlphaBlending();
+	_axesLabels.clear();
+	_axesLabelPositions.clear();
 
-	// Legend outline
-	if (_legendWidth >= 0)
-	{
-		ofLine(_min.x, _min.y, _min.x, _max.y);
-		ofLine(_min.x, _max.y, _min.x + _legendWidth, _max.y);
-		ofLine(_min.x + _legendWidth, _max.y, _min.x + _legendWidth, _min.y);
-		ofLine(_min.x + _legendWidth, _min.y, _min.x, _min.y);
+	// Timescale
+	_axesLabels.push_back(ofToString(_labelTimeWindow) + " sec," + " yScale=" + ofToString(_labelYScale)
+		+ ", yOffset=" + ofToString(_labelYOffset, 1));
+	_axesLabelPositions.push_back(ofPoint(legendX, legendY));
+
+	// Values at the zero line, the top and the bottom of the plot
+	string yVals[3] = { ofToString(-_labelYOffset / _labelYScale),
+		ofToString((-_labelYOffset + _labelWindowHeight / 2) / _labelYScale),
+		ofToString((-_labelYOffset - _labelWindowHeight / 2) / _labelYScale) };
+	ofBitmapFont bitmapFont;
+	for (int k = 0; k < 3; k++) {
+		ofRectangle yValBox = _axesFont.isLoaded() ?
+			_axesFont.getStringBoundingBox(yVals[k], 0, 0) : bitmapFont.getBoundingBox(yVals[k], 0, 0);
+		float y;
+		if (k == 0) {
+			y = yValY + (_axesFont.isLoaded() ? _axesFont.getAscenderHeight() / 2 : yValBox.getHeight() / 2);
+		} else if (k == 1) {
+			y = _min.y - yValBox.getTop() + yLabelPadding;
+		} else {
+			y = _max.y - yLabelPadding;
+		}
+		_axesLabels.push_back(yVals[k]);
+		_axesLabelPositions.push_back(ofPoint(yValX - yValBox.getRight(), y));
 	}
 
-	// Scope outline
-	//ofLine(_min.x, _min.y, _min.x, _max.y);
-	ofLine(_min.x + _legendWidth,	_max.y, _max.x,					_max.y);
-	ofLine(_max.x,					_max.y,	_max.x,					_min.y);
-	ofLine(_max.x,					_min.y, _min.x + _legendWidth,	_min.y);
-
-	ofDisableAlphaBlending(); 
-
-	ofPopStyle();
+	_axesText.clear();
+	_axesText.setMode(OF_PRIMITIVE_TRIANGLES);
+	if (_axesFont.isLoaded()) {
+		for (size_t l = 0; l < _axesLabels.size(); l++) {
+			_axesText.append(_axesFont.getStringMesh(_axesLabels.at(l),
+				_axesLabelPositions.at(l).x, _axesLabelPositions.at(l).y, ofIsVFlipped()));
+		}
+	}
 }
 
 /*
@@ -1403,17 +2879,193 @@ vector<float> ofxMultiScope::decrementTimeWindow() {
 ** Plots the data in all the oscilloscope buffer
 */
 void ofxMultiScope::plot() {
+	drainQueue();
 	for (int i=0; i<scopes.size(); i++) {
 		scopes.at(i).plot();
 	}
 }
 
+/*
+** getDirtyScopes
+** Returns the indexes of the scopes whose next plot() would draw something
+** new. Brings in queued samples first so they count. Call from the thread
+** that plots.
+*/
+std::vector<int> ofxMultiScope::getDirtyScopes() {
+	drainQueue();
+	std::vector<int> dirtyScopes;
+	for (int i = 0; i < scopes.size(); i++) {
+		if (scopes.at(i).isDirty()) {
+			dirtyScopes.push_back(i);
+		}
+	}
+	return dirtyScopes;
+}
+
+/*
+** setOutputCached
+** Lets every scope reuse its rendered panel while it is not dirty; see
+** ofxOscilloscope::setOutputCached.
+*/
+void ofxMultiScope::setOutputCached(bool outputCached) {
+	for (int i = 0; i < scopes.size(); i++) {
+		scopes.at(i).setOutputCached(outputCached);
+	}
+}
+
 void ofxMultiScope::clearData() {
 	for (int i = 0; i<scopes.size(); i++) {
 		scopes.at(i).clearData();
 	}
 }
 
+/*
+** setFrozen
+** Freezes or resumes the display of all scopes; data keeps arriving.
+*/
+void ofxMultiScope::setFrozen(bool frozen) {
+	for (int i = 0; i<scopes.size(); i++) {
+		scopes.at(i).setFrozen(frozen);
+	}
+}
+
+bool ofxMultiScope::isFrozen() {
+	for (int i = 0; i<scopes.size(); i++) {
+		if (scopes.at(i).isFrozen()) return true;
+	}
+	return false;
+}
+
+/*
+** setPlotId
+** Routes samples pushed with plotId to a variable of one of the scopes.
+** loadScopeSettings sets these from the <plotId> of each <plot>.
+*/
+void ofxMultiScope::setPlotId(int plotId, int scope, int variable) {
+	_plotIdIndexes[plotId] = pair<int, int>(scope, variable);
+}
+
+/*
+** setPlotIds
+** Sets the plot IDs of this multiScope from the output of getPlotIdIndexes,
+** where multiScopeIndex is the position of this multiScope in the settings file.
+*/
+void ofxMultiScope::setPlotIds(const std::unordered_map<int, vector<size_t>> &plotIdIndexes,
+	size_t multiScopeIndex) {
+	for (auto it = plotIdIndexes.begin(); it != plotIdIndexes.end(); ++it) {
+		if (it->second.size() == 3 && it->second.at(0) == multiScopeIndex) {
+			setPlotId(it->first, it->second.at(1), it->second.at(2));
+		}
+	}
+}
+
+/*
+** setupQueue
+** Creates a bounded lock-free queue holding capacity samples that any number
+** of threads (up to maxProducers) may push to concurrently with pushData.
+** Queued samples are moved into the scopes in batches at the start of plot().
+**
+** Must be called after the scopes and plot IDs are set up and before any
+** producer thread starts; plot IDs must not change while producers run.
+*/
+void ofxMultiScope::setupQueue(size_t capacity, int maxProducers) {
+	_queue.setup(capacity, maxProducers);
+	_drainBatch.resize(std::min(_queue.getCapacity(), (size_t) 1024));
+}
+
+/*
+** addProducer
+** Registers a producer thread and returns its ID for pushData. Thread safe.
+*/
+int ofxMultiScope::addProducer() {
+	return _queue.addProducer();
+}
+
+/*
+** pushData
+** Queues one sample of plotId from any registered producer thread.
+** Returns false if plotId is unknown (counted as a drop) or the queue is
+** full (counted as an overflow).
+*/
+bool ofxMultiScope::pushData(int producer, int plotId, float value) {
+	return pushData(producer, plotId, value, std::numeric_limits<double>::quiet_NaN());
+}
+
+bool ofxMultiScope::pushData(int producer, int plotId, float value, double timestamp) {
+	if (_plotIdIndexes.find(plotId) == _plotIdIndexes.end()) {
+		_queue.recordDrop(producer);
+		return false;
+	}
+	ofxScopeSample sample;
+	sample.plotId = plotId;
+	sample.value = value;
+	sample.timestamp = timestamp;
+	return _queue.push(producer, sample);
+}
+
+/*
+** drainQueue
+** Moves queued samples into the scopes, handing runs of consecutive samples
+** of the same plot to the scope at once. Drains at most one queue's worth so
+** busy producers can't stall the render thread. Returns the number of
+** samples moved. plot() does this automatically.
+*/
+size_t ofxMultiScope::drainQueue() {
+	size_t nDrained = 0;
+	size_t nPopped;
+	while (nDrained < _queue.getCapacity() &&
+		(nPopped = _queue.pop(_drainBatch.data(), _drainBatch.size())) > 0) {
+		size_t first = 0;
+		while (first < nPopped) {
+			int plotId = _drainBatch.at(first).plotId;
+			_drainValues.clear();
+			_drainTimestamps.clear();
+			size_t last = first;
+			while (last < nPopped && _drainBatch.at(last).plotId == plotId) {
+				_drainValues.push_back(_drainBatch.at(last).value);
+				_drainTimestamps.push_back(_drainBatch.at(last).timestamp);
+				last++;
+			}
+			auto it = _plotIdIndexes.find(plotId);
+			if (it != _plotIdIndexes.end() && it->second.first < scopes.size()) {
+				scopes.at(it->second.first).updateData(it->second.second,
+					_drainValues.data(), _drainTimestamps.data(), _drainValues.size());
+			}
+			first = last;
+		}
+		nDrained += nPopped;
+	}
+	return nDrained;
+}
+
+int ofxMultiScope::getNumProducers() {
+	return _queue.getNumProducers();
+}
+
+/*
+** getPushed
+** Returns the number of samples a producer queued successfully.
+*/
+uint64_t ofxMultiScope::getPushed(int producer) {
+	return _queue.getPushed(producer);
+}
+
+/*
+** getOverflows
+** Returns the number of samples from a producer lost because the queue was full.
+*/
+uint64_t ofxMultiScope::getOverflows(int producer) {
+	return _queue.getOverflows(producer);
+}
+
+/*
+** getDrops
+** Returns the number of samples from a producer dropped for an unknown plotId.
+*/
+uint64_t ofxMultiScope::getDrops(int producer) {
+	return _queue.getDrops(producer);
+}
+
 
 bool ofxMultiScope::saveScopeSettings(vector<ofxMultiScope> &multiScopes, string filename)
 {
@@ -1445,15 +3097,36 @@ bool ofxMultiScope::saveScopeSettings(vector<ofxMultiScope> &multiScopes, string
 			scopeSettings.pushTag("scope", s);
 			scopeSettings.addValue("samplingFrequency", multiScopes.at(m).scopes.at(s).getSamplingFrequency());
 			scopeSettings.addValue("timeWindow", multiScopes.at(m).scopes.at(s).getTimeWindow());
+			scopeSettings.addValue("retention", multiScopes.at(m).scopes.at(s).getRetention());
 			scopeSettings.addValue("yMin", multiScopes.at(m).scopes.at(s).getYLims().first);
 			scopeSettings.addValue("yMax", multiScopes.at(m).scopes.at(s).getYLims().second);
 			scopeSettings.addValue("minYSpan", multiScopes.at(m).scopes.at(s).getMinYSpan());
+			ofxScopePlot::RenderMode renderMode = multiScopes.at(m).scopes.at(s).getRenderMode();
+			if (renderMode == ofxScopePlot::LINE) {
+				scopeSettings.addValue("renderMode", "line");
+			} else if (renderMode == ofxScopePlot::MIN_MAX) {
+				scopeSettings.addValue("renderMode", "minMax");
+			} else if (renderMode == ofxScopePlot::LTTB) {
+				scopeSettings.addValue("renderMode", "lttb");
+			}
 			int nPlots = multiScopes.at(m).scopes.at(s)._scopePlot.getNumVariables();
 			for (int p = 0; p < nPlots; p++) {
 				scopeSettings.addTag("plot");
 				scopeSettings.pushTag("plot", p);
 				scopeSettings.addValue("plotId", plotId++);
 				scopeSettings.addValue("plotName", multiScopes.at(m).scopes.at(s).getVariableName(p));
+				float plotSamplingFrequency = multiScopes.at(m).scopes.at(s).getSamplingFrequency(p);
+				if (plotSamplingFrequency != multiScopes.at(m).scopes.at(s).getSamplingFrequency()) {
+					scopeSettings.addValue("samplingFrequency", plotSamplingFrequency);
+				}
+				ofxScopeSampleFormat sampleFormat = multiScopes.at(m).scopes.at(s).getSampleFormat(p);
+				if (sampleFormat.type == ofxScopeSampleFormat::FLOAT16) {
+					scopeSettings.addValue("sampleFormat", "float16");
+				} else if (sampleFormat.type == ofxScopeSampleFormat::INT16) {
+					scopeSettings.addValue("sampleFormat", "int16");
+					scopeSettings.addValue("sampleScale", sampleFormat.scale);
+					scopeSettings.addValue("sampleOffset", sampleFormat.offset);
+				}
 				scopeSettings.addTag("plotColor");
 				scopeSettings.pushTag("plotColor");
 				ofColor plotColor = multiScopes.at(m).scopes.at(s)._scopePlot.getVariableColor(p);
@@ -1513,20 +3186,35 @@ vector<ofxMultiScope> ofxMultiScope::loadScopeSettings(string filename)
 			scopeSettings.pushTag("scope", s);
 
 			float timeWindow = scopeSettings.getValue("timeWindow", 15.f);
+			float retention = scopeSettings.getValue("retention", timeWindow);
 			float samplingFrequency = scopeSettings.getValue("samplingFrequency", 15.f);
 			float yMin = scopeSettings.getValue("yMin", 0.f);
 			float yMax = scopeSettings.getValue("yMax", 0.f);
 			float minYSpan = scopeSettings.getValue("minYSpan", 0.f);
+			string renderMode = scopeSettings.getValue("renderMode", "auto");
 
 			vector<int> plotIds;
 			vector<string> plotNames;
 			vector<ofColor> plotColors;
+			vector<float> plotSamplingFrequencies;
+			vector<ofxScopeSampleFormat> plotSampleFormats;
 
 			int nPlots = scopeSettings.getNumTags("plot");
 			for (int p = 0; p < nPlots; p++) {
 				scopeSettings.pushTag("plot", p);
 				plotNames.push_back(scopeSettings.getValue("plotName", ofToString(plotId)));
 				plotIds.push_back(scopeSettings.getValue("plotId", plotId++));
+				multiScopes.at(m).setPlotId(plotIds.back(), s, p);
+				plotSamplingFrequencies.push_back(scopeSettings.getValue("samplingFrequency", samplingFrequency));
+				string sampleFormat = scopeSettings.getValue("sampleFormat", "float32");
+				if (sampleFormat == "float16") {
+					plotSampleFormats.push_back(ofxScopeSampleFormat(ofxScopeSampleFormat::FLOAT16));
+				} else if (sampleFormat == "int16") {
+					plotSampleFormats.push_back(ofxScopeSampleFormat(ofxScopeSampleFormat::INT16,
+						scopeSettings.getValue("sampleScale", 1.f), scopeSettings.getValue("sampleOffset", 0.f)));
+				} else {
+					plotSampleFormats.push_back(ofxScopeSampleFormat());
+				}
 				scopeSettings.pushTag("plotColor");
 				plotColors.push_back(ofColor(
 					scopeSettings.getValue("r", 255),
@@ -1537,7 +3225,20 @@ vector<ofxMultiScope> ofxMultiScope::loadScopeSettings(string filename)
 				scopeSettings.popTag(); // plot p
 			}
 
-			multiScopes.at(m).scopes.at(s).setup(timeWindow, samplingFrequency, plotNames, plotColors); // Setup each oscilloscope panel
+			multiScopes.at(m).scopes.at(s).setup(timeWindow, plotSamplingFrequencies, plotNames, plotColors); // Setup each oscilloscope panel
+			multiScopes.at(m).scopes.at(s).setRetention(retention);
+			for (int p = 0; p < nPlots; p++) {
+				multiScopes.at(m).scopes.at(s).setSampleFormat(p, plotSampleFormats.at(p));
+			}
+			if (renderMode == "line") {
+				multiScopes.at(m).scopes.at(s).setRenderMode(ofxScopePlot::LINE);
+			} else if (renderMode == "minMax") {
+				multiScopes.at(m).scopes.at(s).setRenderMode(ofxScopePlot::MIN_MAX);
+			} else if (renderMode == "lttb") {
+				multiScopes.at(m).scopes.at(s).setRenderMode(ofxScopePlot::LTTB);
+			} else {
+				multiScopes.at(m).scopes.at(s).setRenderMode(ofxScopePlot::AUTO);
+			}
 			if (yMin == yMax) {
 				multiScopes.at(m).scopes.at(s).autoscaleY(true, minYSpan);
 			}
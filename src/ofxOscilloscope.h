@@ -15,34 +15,113 @@
 
 #include "ofMain.h"
 #include "ofxXmlSettings.h"
+#include "ofxScopeBuffer.h"
+#include "ofxScopeQueue.h"
+#include "ofxScopeVertexBuffer.h"
+#include "ofxScopeLttb.h"
+#include "ofxScopeStrip.h"
 #include <vector>
+#include <array>
 #include <algorithm>
+#include <memory>
+#include <limits>
 
 #define OFX_SUPPORT_VERSION_MAJOR_0 0
 #define OFX_SUPPORT_VERSION_MINOR_9 9
 #define OFX_SUPPORT_VERSION_MINOR_10 10
 
+#define OFX_SCOPE_RENDER_SLACK 0.25	// Seconds of samples ingest may run ahead of the frame being drawn
+#define OFX_SCOPE_DYNAMIC_CHANNELS -1	// ofxScopePlotT channel count taken from setup
+#define OFX_SCOPE_DECIMATION_THRESHOLD 2	// Samples per pixel column above which AUTO plots the min/max envelope
+#define OFX_SCOPE_LTTB_POINTS_PER_PIXEL 1	// Samples LTTB keeps per pixel column of the plot width
+
 /*-------------------------------------------------
 * ofxScopePlot
 * Class to handle the plotting of data for ofxOscilloscope
 *-------------------------------------------------*/
 class ofxScopePlot {
+public:
+	enum RenderMode {
+		AUTO,		// LINE, or MIN_MAX above the decimation threshold
+		LINE,		// A segment between every pair of samples
+		MIN_MAX,	// The min-max span of each pixel column, joined column to column
+		LTTB		// Largest-Triangle-Three-Buckets: a few samples per pixel column keeping the shape
+	};
+
 private:
 	ofPoint _min;
 	ofPoint _max;
 	float _timeWindow;
-	int _pointsPerWin; //(nPoints)
-	float _sampFreq;
+	float _retention;	// Seconds of samples held; at least _timeWindow
+	float _scrollOffset;	// Seconds between the newest sample and the right edge
+	string _historyDirectory;
+	float _historySeconds;	// Seconds spilled to disk; 0 without a history
+	int _pointsPerWin; //(nPoints) of the fastest variable
+	float _sampFreq;	// Highest sampling frequency of the variables
+	std::vector<float> _sampFreqs;	// Sampling frequency of each variable
 	int _nVariables;
 	std::vector<ofColor> _variableColors;
-	std::vector< vector<float > > _buffer;
+	ofxScopeBuffer _buffer;
+	ofxScopeSpscQueue _queue;	// Frames pushed from an acquisition thread; its drain is then the only writer
+	ofxScopeTripleBuffer<ofxScopeSnapshot> _snapshots;	// Buffer state published for plot()
+	struct FrozenCopy {
+		uint64_t freeze;		// _freezeCount of the freeze it was copied for
+		ofxScopeBuffer buffer;
+	};
+	ofxScopeAtomic<bool> _frozen;
+	ofxScopeAtomic<uint64_t> _freezeCount;	// Bumped by every setFrozen(true)
+	std::shared_ptr<const FrozenCopy> _frozenCopy;	// Made by the updating thread; std::atomic_load/atomic_store only
+	uint64_t _copiedFreeze;		// Freeze of the last copy made; updating thread
+	std::shared_ptr<const FrozenCopy> _frozenHeld;	// Copy plotted while frozen; render thread
+	ofxScopeSnapshot _frozenSnapshot;	// Published state pinned by setFrozen; render thread
 	float _yScale;
 	float _yOffset;
 	ofColor _zeroLineColor;
 	ofColor _backgroundColor;
 	float _plotLineWidth;
 	pair<float, float> _yLims;
-
+	ofMesh _lineStrip;	// Vertices of the variable being drawn; reused so its storage persists
+	RenderMode _renderMode;
+	float _decimationThreshold;	// Samples per pixel column
+	ofxScopeVertexBuffer::Mode _vertexMode;
+	std::vector<ofxScopeVertexBuffer> _vertexBuffers;	// Ring of each variable as vertices
+	std::vector<ofxScopeLttb> _lttb;	// Kept LTTB choices of each variable
+	bool _scrollingStrip;
+	std::vector<ofxScopeStrip> _strips;	// Rasterized trace of each variable
+
+	// Change tracking
+	ofxScopeAtomic<uint64_t> _generation;	// Count of publish() calls; only the updating thread writes it
+	ofxScopeAtomic<uint64_t> _revision;		// Bumped by setters that change how the data is drawn
+	bool _plotted;
+	uint64_t _plottedGeneration;	// Generation and revision last drawn by plotTraces
+	uint64_t _plottedRevision;
+	int _plottedWindowHeight;	// y scaling follows the window height
+
+	int getPointsPerWin(int i);
+	size_t getRenderSlack(int i);
+	std::vector<size_t> getCapacities();
+	void updateWindows();
+	bool hasHistory();
+	bool acceptsUpdates();
+	uint64_t getVisibleEnd(const ofxScopeView &view, int i);
+	uint64_t getVisibleStart(uint64_t last, int pointsPerWin, uint64_t oldest);
+	void publish();
+	ofxScopeView getView();
+	bool plotVariable(const ofxScopeView &view, int i, uint64_t oldest, int pointsPerWin,
+		float xPlotScale, float yPlotScale, float yPlotOffset);	// False if the samples read were overwritten
+	bool plotLine(const ofxScopeView &view, int i, uint64_t oldest, int pointsPerWin,
+		float xPlotScale, float yPlotScale, float yPlotOffset);
+	bool plotEnvelope(const ofxScopeView &view, int i, uint64_t oldest, int pointsPerWin,
+		float xPlotScale, float yPlotScale, float yPlotOffset);
+	void plotTimestamped(const ofxScopeView &view, float yPlotScale, float yPlotOffset);
+	bool plotLttb(const ofxScopeView &view, int i, uint64_t oldest, int pointsPerWin,
+		float xPlotScale, float yPlotScale, float yPlotOffset);
+	bool plotStrip(const ofxScopeView &view, int i, uint64_t oldest, int pointsPerWin,
+		float xPlotScale, float yPlotScale, float yPlotOffset);
+	bool isDecimated(double nPoints);
+	size_t getLttbPoints();
+
+	template <class SampleT, int NChannels> friend class ofxScopePlotT;
 
 public:
 
@@ -61,15 +140,58 @@ public:
 		float yScale=1.0, float yOffset=0.0);
 	void setup(float timeWindow, float sampFreq, ofColor variableColors[], int nVariables, 
 		float yScale=1.0, float yOffset=0.0);
+	void setup(float timeWindow, std::vector<float> sampFreqs, std::vector<ofColor> variableColors,
+		float yScale=1.0, float yOffset=0.0); // sampFreqs[nVariables]
 
 	// Updating data
-	void updateData(std::vector<float> data); // data[_nVariables]
-	void updateData(std::vector<std::vector<float> > data); // data[_nVariables][nPoints]
+	void updateData(const std::vector<float> &data); // data[_nVariables]
+	void updateData(const std::vector<std::vector<float> > &data); // data[_nVariables][nPoints]
+	void updateData(size_t variableNum, const float * data, size_t nPoints, size_t stride = 1); // data[nPoints * stride]
+	void updateData(size_t variableNum, ofxScopeSpan data); // data[nPoints]
+	void updateData(const ofxScopeSpan data[], int nVariables); // data[_nVariables][nPoints]
 	void updateData(float ** data, int nPoints); // ** DEPRECATED ** data[_nVariables][nPoints]
+	bool updateDataInterleaved(const float * frames, size_t nFrames, int nVariables); // frames[nFrames][_nVariables]
+	bool updateDataInterleaved(const std::vector<float> &frames, int nVariables); // frames[nFrames * _nVariables]
+	void updateData(const std::vector<float> &data, double timestamp); // data[_nVariables] sampled at timestamp
+	void updateData(size_t variableNum, const float * data, const double * timestamps,
+		size_t nPoints, size_t stride = 1); // data[nPoints * stride], timestamps[nPoints]
+	void updateData(size_t variableNum, const int16_t * codes, size_t nPoints, size_t stride = 1); // Raw INT16 codes
 	void clearData();	// Sets all data to the most recent value;
 
+	// Ingest queue (one producer thread, drained by the render thread; updateData is then refused)
+	void setupQueue(size_t capacity);	// Frames held; 0 disables the queue
+	bool pushData(const float * frame);	// frame[_nVariables]; producer thread
+	bool pushData(const std::vector<float> &data); // data[_nVariables]; producer thread
+	bool pushData(const std::vector<float> &data, double timestamp); // data[_nVariables] sampled at timestamp
+	size_t pushDataInterleaved(const float * frames, size_t nFrames); // frames[nFrames][_nVariables]; producer thread
+	size_t drainQueue();	// Moves queued frames into the plot buffer; render thread
+	uint64_t getOverruns();	// Frames dropped because the queue was full
+	uint64_t resetOverruns();
+
 	// Plotting
 	void plot();
+	void plotBackground();	// Background and zero line only
+	void plotTraces();		// Data only, over a background drawn by plotBackground or the owner
+	void setFrozen(bool frozen);	// Holds the displayed data while updates continue
+	bool isFrozen();
+	void setVertexMode(ofxScopeVertexBuffer::Mode mode);	// GPU vertex buffers, or CPU for software GL
+	ofxScopeVertexBuffer::Mode getVertexMode();
+	void setRenderMode(RenderMode renderMode);
+	RenderMode getRenderMode();
+	void setDecimationThreshold(float samplesPerPixel);	// Used by AUTO
+	float getDecimationThreshold();
+	void setScrollingStrip(bool scrollingStrip);	// Draws only samples new since the last frame
+	bool isScrollingStrip();
+
+	// Change tracking
+	bool isDirty();		// True if plotTraces would draw something other than last time
+	uint64_t getGeneration();	// Changes with every update of the data
+	uint64_t getRevision();		// Changes with every setter affecting the plot
+
+	// Timestamped samples
+	void setTimestamped(bool timestamped);
+	bool isTimestamped();
+	double getNewestTimestamp();
 
 	// Setters/Getters
 	void setVariableColors(std::vector<ofColor> colors);
@@ -78,13 +200,28 @@ public:
 	void setPlotLineWidth(float plotLineWidth);
 
 	void setZeroLineColor(ofColor zeroLineColor);
+	ofColor getZeroLineColor();
 	void setBackgroundColor(ofColor backgroundColor);
+	ofColor getBackgroundColor();
 
 	void setPosition(ofPoint min, ofPoint max);
 	void setPosition(ofRectangle plotArea);
 	ofRectangle getPosition();
 
 	void setTimeWindow(float timeWindow);
+	void setRetention(float retention);
+	float getRetention();
+
+	// Deep history
+	void setupHistory(string directory, float seconds);	// seconds <= 0 disables the history
+	void setupCompressedHistory(float seconds);		// In memory; seconds <= 0 disables the history
+	void setScrollOffset(float seconds);
+	float getScrollOffset();
+
+	// Sample storage
+	void setSampleFormat(const ofxScopeSampleFormat &format);	// All variables
+	void setSampleFormat(int i, const ofxScopeSampleFormat &format);
+	ofxScopeSampleFormat getSampleFormat(int i);
 
 	void setYScale(float yScale);
 	float getYScale();
@@ -98,6 +235,78 @@ public:
 	ofColor getVariableColor(int i);
 	float getTimeWindow();
 	float getSamplingFrequency();
+	float getSamplingFrequency(int i);
+};
+
+/*-------------------------------------------------
+* ofxScopePlotT
+* ofxScopePlot with the sample type, and optionally
+* the number of variables, fixed at compile time.
+* Each frame goes to the buffer in one
+* ofxScopeBuffer::pushFrame, with no vector in between;
+* int16_t samples are kept as raw INT16 codes. setup
+* sets the sample format of every variable to match
+* SampleT, and refuses variableColors whose size is not
+* NChannels rather than reporting mismatched frames.
+*
+* With NChannels = OFX_SCOPE_DYNAMIC_CHANNELS the
+* number of variables comes from setup, as with
+* ofxScopePlot itself.
+*-------------------------------------------------*/
+template <class SampleT, int NChannels = OFX_SCOPE_DYNAMIC_CHANNELS>
+class ofxScopePlotT : public ofxScopePlot {
+private:
+	int getFrameSize() {
+		return (NChannels == OFX_SCOPE_DYNAMIC_CHANNELS) ? _buffer.getNumChannels() : NChannels;
+	}
+
+	static bool checkNumVariables(size_t nVariables) {
+		if (NChannels != OFX_SCOPE_DYNAMIC_CHANNELS && nVariables != NChannels) {
+			fprintf(stderr, "ERROR: ofxScopePlotT variableColors.size() != NChannels, setup refused\n");
+			return false;
+		}
+		return true;
+	}
+
+	void setupSampleFormats() {
+		for (int i = 0; i < getNumVariables(); i++) {
+			// Keep the scale and offset of a matching format
+			if (getSampleFormat(i).type != ofxScopeSampleTraits<SampleT>::type) {
+				setSampleFormat(i, ofxScopeSampleFormat(ofxScopeSampleTraits<SampleT>::type));
+			}
+		}
+	}
+
+public:
+	using ofxScopePlot::ofxScopePlot;
+	using ofxScopePlot::updateData;
+
+	void setup(float timeWindow, float sampFreq, std::vector<ofColor> variableColors,
+		float yScale=1.0, float yOffset=0.0) {
+		if (!checkNumVariables(variableColors.size())) return;
+		ofxScopePlot::setup(timeWindow, sampFreq, variableColors, yScale, yOffset);
+		setupSampleFormats();
+	}
+	void setup(float timeWindow, std::vector<float> sampFreqs, std::vector<ofColor> variableColors,
+		float yScale=1.0, float yOffset=0.0) {
+		if (!checkNumVariables(variableColors.size())) return;
+		ofxScopePlot::setup(timeWindow, sampFreqs, variableColors, yScale, yOffset);
+		setupSampleFormats();
+	}
+
+	// frame[NChannels], or frame[getNumVariables()] when dynamic; ignored before setup
+	void updateData(const SampleT * frame) {
+		if (acceptsUpdates() && _buffer.pushFrame(frame, getFrameSize())) {
+			publish();
+		}
+	}
+
+	template <size_t N>
+	void updateData(const std::array<SampleT, N> &frame) {
+		static_assert(NChannels == OFX_SCOPE_DYNAMIC_CHANNELS || N == NChannels,
+			"frame size differs from NChannels");
+		updateData(frame.data());
+	}
 };
 
 
@@ -122,6 +331,34 @@ private:
 	ofColor _backgroundColor;
 	bool _autoscaleY;
 	float _minYSpan;
+	float _autoscaleHysteresis;
+	pair<float, float> _autoscaleLims;	// Data limits the current yScale/yOffset were fit to
+
+	// Static parts of the panel, rebuilt only when a setter changes them
+	bool _chromeDirty;
+	ofMesh _chromeFill;		// Legend and plot backgrounds and the zero line
+	ofMesh _legendText;		// Variable names in _legendFont, colored per variable
+	ofMesh _chromeOutline;	// Legend and scope outlines, drawn over the data
+
+	// Axes labels, rebuilt only when the values they show change
+	bool _labelsDirty;
+	float _labelTimeWindow;	// Values the labels were built for
+	float _labelYScale;
+	float _labelYOffset;
+	int _labelWindowHeight;
+	std::vector<string> _axesLabels;
+	std::vector<ofPoint> _axesLabelPositions;
+	ofMesh _axesText;		// Glyphs of _axesLabels in _axesFont
+
+	// Rendered panel, reused while nothing changes
+	bool _outputCached;
+	bool _panelDirty;		// Set by panel setters not covered by _chromeDirty or the plot's revision
+	ofFbo _output;			// Premultiplied alpha
+
+	void buildChrome();
+	void buildAxesLabels();
+	void plotPanel();
+	void plotCached();
 
 public:
 	ofxScopePlot _scopePlot;
@@ -150,27 +387,74 @@ public:
 	void setup(float timeWindow, float sampFreq,
 		string variableNames[], ofColor variableColors[], int nVariables, 
 		float yScale=1.0, float yOffset=0.0);
+	void setup(float timeWindow, std::vector<float> sampFreqs,
+		std::vector<string> variableNames, std::vector<ofColor> variableColors,
+		float yScale = 1.0, float yOffset = 0.0); // sampFreqs[nVariables]
 
 	// Updating data
-	void updateData(std::vector<float> data); // data[_nVariables] or data[nPoints] iff _nVariables==1
-	void updateData(std::vector<std::vector<float> > data); // data[_nVariables][nPoints]
-	void updateData(size_t variableNum, std::vector<float> data); // data[nPoints]
+	void updateData(const std::vector<float> &data); // data[_nVariables] or data[nPoints] iff _nVariables==1
+	void updateData(const std::vector<std::vector<float> > &data); // data[_nVariables][nPoints]
+	void updateData(size_t variableNum, const std::vector<float> &data); // data[nPoints]
+	void updateData(size_t variableNum, const float * data, size_t nPoints, size_t stride = 1); // data[nPoints * stride]
+	void updateData(size_t variableNum, ofxScopeSpan data); // data[nPoints]
+	void updateData(const ofxScopeSpan data[], int nVariables); // data[_nVariables][nPoints]
 	void updateData(float ** data, int nPoints); // ** DEPRECATED ** data[_nVariables][nPoints] 
+	bool updateDataInterleaved(const float * frames, size_t nFrames, int nVariables); // frames[nFrames][_nVariables]
+	bool updateDataInterleaved(const std::vector<float> &frames, int nVariables); // frames[nFrames * _nVariables]
+	void updateData(const std::vector<float> &data, double timestamp); // data[_nVariables] sampled at timestamp
+	void updateData(size_t variableNum, const float * data, const double * timestamps,
+		size_t nPoints, size_t stride = 1); // data[nPoints * stride], timestamps[nPoints]
+	void updateData(size_t variableNum, const int16_t * codes, size_t nPoints, size_t stride = 1); // Raw INT16 codes
 	void clearData();	// Sets all data to the most recent value;
 
+	// Ingest queue (one producer thread, drained by plot())
+	void setupQueue(size_t capacity);	// Frames held; 0 disables the queue
+	bool pushData(const float * frame);	// frame[_nVariables]; producer thread
+	bool pushData(const std::vector<float> &data); // data[_nVariables]; producer thread
+	bool pushData(const std::vector<float> &data, double timestamp); // data[_nVariables] sampled at timestamp
+	size_t pushDataInterleaved(const float * frames, size_t nFrames); // frames[nFrames][_nVariables]; producer thread
+	size_t drainQueue();	// Moves queued frames into the plot buffer; render thread
+	uint64_t getOverruns();	// Frames dropped because the queue was full
+	uint64_t resetOverruns();
+
 	// Plotting
 	void plot();
+	void setFrozen(bool frozen);	// Holds the displayed data while updates continue
+	bool isFrozen();
+	void setVertexMode(ofxScopeVertexBuffer::Mode mode);	// GPU vertex buffers, or CPU for software GL
+	ofxScopeVertexBuffer::Mode getVertexMode();
+	void setRenderMode(ofxScopePlot::RenderMode renderMode);	// LINE, MIN_MAX per pixel column, LTTB, or AUTO
+	ofxScopePlot::RenderMode getRenderMode();
+	void setDecimationThreshold(float samplesPerPixel);		// Samples per pixel column above which AUTO uses MIN_MAX
+	float getDecimationThreshold();
+	void setScrollingStrip(bool scrollingStrip);	// Keep traces in offscreen strips, drawing only new samples
+	bool isScrollingStrip();
+	void setOutputCached(bool outputCached);	// Reuse the rendered panel while the scope is not dirty
+	bool isOutputCached();
+	bool isDirty();		// True if plot() would draw something other than last time
 
 	// Setters/Getters
+	void setTimestamped(bool timestamped);		// Position samples by timestamp (seconds)
+	bool isTimestamped();
 	void setVariableNames(std::vector<string> variableNames);		// Variable names
 	void setVariableNames(string variableNames[], int nVariables);	// Variable names
 
 	void setVariableColors(std::vector<ofColor> colors);			// Variable colors
 	void setVariableColors(ofColor colors[], int nColors);			// Variable colors
 
-	float getSamplingFrequency();
+	float getSamplingFrequency();				// Highest sampling frequency of the variables
+	float getSamplingFrequency(int i);			// Sampling frequency of a selected variable
 	void setTimeWindow(float timeWindow);		// Duration of displayed data window (seconds)
 	float getTimeWindow();						// Duration of displayed data window (seconds)
+	void setRetention(float retention);			// Duration of data kept for zooming out (seconds)
+	float getRetention();						// Duration of data kept for zooming out (seconds)
+	void setupHistory(string directory, float seconds);	// Duration of data spilled to disk (seconds)
+	void setupCompressedHistory(float seconds);	// Duration of data kept compressed in memory (seconds)
+	void setScrollOffset(float seconds);		// How far back the right edge shows (seconds)
+	float getScrollOffset();					// How far back the right edge shows (seconds)
+	void setSampleFormat(const ofxScopeSampleFormat &format);		// Storage format of all variables
+	void setSampleFormat(int i, const ofxScopeSampleFormat &format);	// Storage format of a selected variable
+	ofxScopeSampleFormat getSampleFormat(int i);					// Storage format of a selected variable
 	void setPosition(ofPoint min, ofPoint max);	// Position of the scope panel
 	void setPosition(ofRectangle scopeArea);	// Position of the scope panel
 	ofRectangle getPosition();					// Position of the scope panel
@@ -191,7 +475,7 @@ public:
 	float getYScale();				// yScale of plotted data
 	void setYOffset(float yOffset);	// yScale of plotted data
 	float getYOffset();				// yScale of plotted data
-	void autoscaleY(bool autoscale, float minYSpan = 0.f);
+	void autoscaleY(bool autoscale, float minYSpan = 0.f, float hysteresis = 0.f);
 	void setYLims(pair<float,float> yLims);
 	pair<float, float> getYLims();
 	float getMinYSpan();
@@ -223,6 +507,13 @@ private:
 	ofPoint _min;
 	ofPoint _max;
 	int _numScopes;
+
+	// Multi-producer ingestion
+	std::unordered_map<int, pair<int, int> > _plotIdIndexes;	// plotId -> (scope, variable)
+	ofxScopeMpscQueue _queue;
+	std::vector<ofxScopeSample> _drainBatch;	// Scratch for drainQueue
+	std::vector<float> _drainValues;
+	std::vector<double> _drainTimestamps;
 public:
 
 	std::vector<ofxOscilloscope> scopes;
@@ -256,6 +547,26 @@ public:
 	// Plotting
 	void plot();
 	void clearData();
+	void setFrozen(bool frozen);	// Holds the displayed data of all scopes while updates continue
+	bool isFrozen();				// True if any scope is frozen
+	std::vector<int> getDirtyScopes();	// Indexes of the scopes plot() would redraw
+	void setOutputCached(bool outputCached);	// Scopes reuse their rendered panel while not dirty
+
+	// Plot IDs
+	void setPlotId(int plotId, int scope, int variable);
+	void setPlotIds(const std::unordered_map<int, vector<size_t>> &plotIdIndexes,
+		size_t multiScopeIndex);	// Entries of getPlotIdIndexes for this multiScope
+
+	// Ingest queue (any number of producer threads, drained by plot())
+	void setupQueue(size_t capacity, int maxProducers);	// Samples held; 0 disables the queue
+	int addProducer();	// Producer ID for pushData, or -1 if maxProducers are registered
+	bool pushData(int producer, int plotId, float value);	// Any thread
+	bool pushData(int producer, int plotId, float value, double timestamp);	// timestamp in seconds
+	size_t drainQueue();	// Moves queued samples into the scopes; render thread
+	int getNumProducers();
+	uint64_t getPushed(int producer);		// Samples queued by a producer
+	uint64_t getOverflows(int producer);	// Samples lost because the queue was full
+	uint64_t getDrops(int producer);		// Samples with an unknown plotId
 
 	// Setters/Getters
 	void setTimeWindow(float timeWindow);		// Duration of displayed data window (seconds)
@@ -0,0 +1,1475 @@
+//
+//  ofxScopeBuffer.cpp
+//
+//  Circular sample storage for ofxScopePlot
+//
+//  This work is licensed under the Creative Commons
+//  Attribution-ShareAlike 3.0 Unported License.
+//  To view a copy of this license, visit http://creativecommons.org/licenses/by-sa/3.0/.
+//
+#include "ofxScopeBuffer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <limits>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define OFX_SCOPE_SSE
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define OFX_SCOPE_NEON
+#endif
+#if defined(__F16C__)
+#include <immintrin.h>
+#define OFX_SCOPE_F16C
+#endif
+
+/*
+** ofxScopeDeinterleave
+** Splits interleaved frames into per-channel arrays.
+** Each vector loop handles as many whole blocks as it can; the remaining
+** frames (and unsupported channel counts) fall through to the scalar loop.
+*/
+void ofxScopeDeinterleave(const float * src, size_t nFrames, int nChannels, float * const * dst) {
+	size_t f = 0;
+
+#if defined(__AVX2__)
+	if (nChannels == 2) {
+		for (; f + 8 <= nFrames; f += 8) {
+			__m256 a = _mm256_loadu_ps(src + 2 * f);
+			__m256 b = _mm256_loadu_ps(src + 2 * f + 8);
+			// Per 128 bit lane: [a0 a2 b0 b2] / [a1 a3 b1 b3], then fix the lane order
+			__m256 even = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+			__m256 odd = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+			even = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(even), _MM_SHUFFLE(3, 1, 2, 0)));
+			odd = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(odd), _MM_SHUFFLE(3, 1, 2, 0)));
+			_mm256_storeu_ps(dst[0] + f, even);
+			_mm256_storeu_ps(dst[1] + f, odd);
+		}
+	}
+#endif
+
+#if defined(OFX_SCOPE_SSE)
+	if (nChannels == 2) {
+		for (; f + 4 <= nFrames; f += 4) {
+			__m128 a = _mm_loadu_ps(src + 2 * f);
+			__m128 b = _mm_loadu_ps(src + 2 * f + 4);
+			_mm_storeu_ps(dst[0] + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(dst[1] + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+	} else if (nChannels == 4) {
+		for (; f + 4 <= nFrames; f += 4) {
+			__m128 r0 = _mm_loadu_ps(src + 4 * f);
+			__m128 r1 = _mm_loadu_ps(src + 4 * f + 4);
+			__m128 r2 = _mm_loadu_ps(src + 4 * f + 8);
+			__m128 r3 = _mm_loadu_ps(src + 4 * f + 12);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(dst[0] + f, r0);
+			_mm_storeu_ps(dst[1] + f, r1);
+			_mm_storeu_ps(dst[2] + f, r2);
+			_mm_storeu_ps(dst[3] + f, r3);
+		}
+	}
+#endif
+
+#if defined(OFX_SCOPE_NEON)
+	if (nChannels == 2) {
+		for (; f + 4 <= nFrames; f += 4) {
+			float32x4x2_t v = vld2q_f32(src + 2 * f);
+			vst1q_f32(dst[0] + f, v.val[0]);
+			vst1q_f32(dst[1] + f, v.val[1]);
+		}
+	} else if (nChannels == 3) {
+		for (; f + 4 <= nFrames; f += 4) {
+			float32x4x3_t v = vld3q_f32(src + 3 * f);
+			vst1q_f32(dst[0] + f, v.val[0]);
+			vst1q_f32(dst[1] + f, v.val[1]);
+			vst1q_f32(dst[2] + f, v.val[2]);
+		}
+	} else if (nChannels == 4) {
+		for (; f + 4 <= nFrames; f += 4) {
+			float32x4x4_t v = vld4q_f32(src + 4 * f);
+			vst1q_f32(dst[0] + f, v.val[0]);
+			vst1q_f32(dst[1] + f, v.val[1]);
+			vst1q_f32(dst[2] + f, v.val[2]);
+			vst1q_f32(dst[3] + f, v.val[3]);
+		}
+	}
+#endif
+
+	// Scalar fallback
+	for (; f < nFrames; f++) {
+		const float * frame = src + f * nChannels;
+		for (int c = 0; c < nChannels; c++) {
+			dst[c][f] = frame[c];
+		}
+	}
+}
+
+/*-------------------------------------------------
+* Sample formats
+*-------------------------------------------------*/
+
+/*
+** halfFromFloat
+** Converts a float to IEEE 754 half precision, rounding to nearest even.
+** Values beyond the half range become infinity.
+*/
+static inline uint16_t halfFromFloat(float value) {
+#if defined(OFX_SCOPE_F16C)
+	return _cvtss_sh(value, 0);
+#else
+	const uint32_t infinity = 255u << 23;
+	const uint32_t halfOverflow = (127u + 16) << 23;	// 2^16, the first value rounding past the range
+	const uint32_t denormalMagic = ((127u - 15) + (23 - 10) + 1) << 23;
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = bits & 0x80000000u;
+	bits ^= sign;
+
+	uint16_t half;
+	if (bits >= halfOverflow) {
+		half = (bits > infinity) ? 0x7E00 : 0x7C00;	// NaN stays NaN
+	} else if (bits < (113u << 23)) {
+		// Subnormal half: let the FPU round the mantissa by adding a magic number
+		float f, magic;
+		memcpy(&f, &bits, sizeof(f));
+		memcpy(&magic, &denormalMagic, sizeof(magic));
+		f += magic;
+		memcpy(&bits, &f, sizeof(bits));
+		half = (uint16_t) (bits - denormalMagic);
+	} else {
+		uint32_t mantissaOdd = (bits >> 13) & 1;
+		bits += 0xC8000000u + 0xFFF;	// Rebias the exponent (15 - 127) and round
+		bits += mantissaOdd;
+		half = (uint16_t) (bits >> 13);
+	}
+	return half | (uint16_t) (sign >> 16);
+#endif
+}
+
+/*
+** floatFromHalf
+** Converts an IEEE 754 half precision value to float (exact).
+*/
+static inline float floatFromHalf(uint16_t half) {
+#if defined(OFX_SCOPE_F16C)
+	return _cvtsh_ss(half);
+#else
+	const uint32_t exponentMask = 0x7C00u << 13;
+	uint32_t bits = (uint32_t) (half & 0x7FFF) << 13;
+	uint32_t exponent = bits & exponentMask;
+	bits += (127u - 15) << 23;
+	float value;
+	if (exponent == exponentMask) {
+		bits += (128u - 16) << 23;		// Infinity or NaN
+	} else if (exponent == 0) {
+		// Zero or subnormal: renormalize through the FPU
+		const uint32_t magicBits = 113u << 23;
+		float magic;
+		memcpy(&magic, &magicBits, sizeof(magic));
+		bits += 1u << 23;
+		memcpy(&value, &bits, sizeof(value));
+		value -= magic;
+		memcpy(&bits, &value, sizeof(bits));
+	}
+	bits |= (uint32_t) (half & 0x8000) << 16;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+#endif
+}
+
+/*
+** codeFromValue
+** Returns the INT16 code nearest to value, clamped to the code range.
+*/
+static inline int16_t codeFromValue(float value, const ofxScopeSampleFormat &format) {
+	float code = (value - format.offset) / format.scale;
+	if (std::isnan(code)) return 0;
+	code = std::min(std::max(code, -32768.f), 32767.f);
+	return (int16_t) std::lrint(code);
+}
+
+/*
+** loadSample
+** Returns sample i of storage base in the given format as a float.
+*/
+static inline float loadSample(const ofxScopeSampleFormat &format, const float * base, size_t i) {
+	switch (format.type) {
+	case ofxScopeSampleFormat::FLOAT16:
+		return floatFromHalf(reinterpret_cast<const uint16_t *>(base)[i]);
+	case ofxScopeSampleFormat::INT16:
+		return reinterpret_cast<const int16_t *>(base)[i] * format.scale + format.offset;
+	default:
+		return base[i];
+	}
+}
+
+/*
+** storeSample
+** Converts value to the given format and stores it as sample i of base.
+*/
+static inline void storeSample(const ofxScopeSampleFormat &format, float * base, size_t i, float value) {
+	switch (format.type) {
+	case ofxScopeSampleFormat::FLOAT16:
+		reinterpret_cast<uint16_t *>(base)[i] = halfFromFloat(value);
+		break;
+	case ofxScopeSampleFormat::INT16:
+		reinterpret_cast<int16_t *>(base)[i] = codeFromValue(value, format);
+		break;
+	default:
+		base[i] = value;
+	}
+}
+
+/*
+** floatsFor
+** Returns the floats of storage taken by nSamples samples of a format,
+** rounded up to whole OFX_SCOPE_BUFFER_ALIGNMENT lines.
+*/
+static size_t floatsFor(const ofxScopeSampleFormat &format, size_t nSamples) {
+	const size_t floatsPerLine = OFX_SCOPE_BUFFER_ALIGNMENT / sizeof(float);
+	size_t nFloats = (nSamples * format.getSampleSize() + sizeof(float) - 1) / sizeof(float);
+	return (nFloats + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+}
+
+/*-------------------------------------------------
+* ofxScopeAlignedArray
+*-------------------------------------------------*/
+
+/*
+** ofxScopeAlignedArray
+*/
+ofxScopeAlignedArray::ofxScopeAlignedArray() {
+	_allocation = NULL;
+	_data = NULL;
+	_size = 0;
+}
+
+ofxScopeAlignedArray::ofxScopeAlignedArray(const ofxScopeAlignedArray &other) {
+	_allocation = NULL;
+	_data = NULL;
+	_size = 0;
+	*this = other;
+}
+
+ofxScopeAlignedArray& ofxScopeAlignedArray::operator=(const ofxScopeAlignedArray &other) {
+	if (this != &other) {
+		allocate(other._size);
+		std::copy(other._data, other._data + _size, _data);
+	}
+	return *this;
+}
+
+ofxScopeAlignedArray::~ofxScopeAlignedArray() {
+	free(_allocation);
+}
+
+/*
+** allocate
+** Reallocates the array if its size changes.
+*/
+void ofxScopeAlignedArray::allocate(size_t size) {
+	if (size == _size) return;
+	free(_allocation);
+	_allocation = NULL;
+	_data = NULL;
+	_size = size;
+	if (_size > 0) {
+		_allocation = malloc(_size * sizeof(float) + OFX_SCOPE_BUFFER_ALIGNMENT);
+		uintptr_t address = reinterpret_cast<uintptr_t>(_allocation);
+		address = (address + OFX_SCOPE_BUFFER_ALIGNMENT - 1) & ~(uintptr_t)(OFX_SCOPE_BUFFER_ALIGNMENT - 1);
+		_data = reinterpret_cast<float *>(address);
+	}
+}
+
+/*-------------------------------------------------
+* ofxScopeMonotonicQueue
+*-------------------------------------------------*/
+
+/*
+** ofxScopeMonotonicQueue
+*/
+ofxScopeMonotonicQueue::ofxScopeMonotonicQueue(bool isMax) {
+	_isMax = isMax;
+	_front = 0;
+	_count = 0;
+}
+
+/*
+** clear
+*/
+void ofxScopeMonotonicQueue::clear() {
+	_front = 0;
+	_count = 0;
+}
+
+/*
+** grow
+** Doubles the ring storage, unwrapping the entries to start at 0.
+*/
+void ofxScopeMonotonicQueue::grow() {
+	size_t capacity = std::max((size_t) 16, 2 * _index.size());
+	std::vector<uint64_t> index(capacity);
+	std::vector<float> value(capacity);
+	for (size_t i = 0; i < _count; i++) {
+		size_t j = (_front + i) % _index.size();
+		index[i] = _index[j];
+		value[i] = _value[j];
+	}
+	_index.swap(index);
+	_value.swap(value);
+	_front = 0;
+}
+
+/*
+** push
+** Appends a sample, first dropping every entry from the back that it dominates.
+*/
+void ofxScopeMonotonicQueue::push(uint64_t index, float value) {
+	while (_count > 0) {
+		size_t back = (_front + _count - 1) % _index.size();
+		bool dominated = _isMax ? (_value[back] <= value) : (_value[back] >= value);
+		if (!dominated) break;
+		_count--;
+	}
+	if (_count == _index.size()) {
+		grow();
+	}
+	size_t slot = (_front + _count) % _index.size();
+	_index[slot] = index;
+	_value[slot] = value;
+	_count++;
+}
+
+/*
+** evict
+** Drops entries that have slid out of the window.
+*/
+void ofxScopeMonotonicQueue::evict(uint64_t oldestIndex) {
+	while (_count > 0 && _index[_front] < oldestIndex) {
+		_front++;
+		if (_front == _index.size()) _front = 0;
+		_count--;
+	}
+}
+
+bool ofxScopeMonotonicQueue::empty() const {
+	return _count == 0;
+}
+
+float ofxScopeMonotonicQueue::front() const {
+	return _value[_front];
+}
+
+/*-------------------------------------------------
+* ofxScopeBuffer
+*-------------------------------------------------*/
+
+/*
+** ofxScopeBuffer
+*/
+ofxScopeBuffer::ofxScopeBuffer() {
+	_timestamped = false;
+	_timeWindow = 0;
+}
+
+/*
+** ~ofxScopeBuffer
+*/
+ofxScopeBuffer::~ofxScopeBuffer() {
+}
+
+/*
+** allocate
+** (Re)allocates the arena, pyramid and timestamp storage for one channel per
+** entry of capacities. Every channel's ring and pyramid start on a
+** OFX_SCOPE_BUFFER_ALIGNMENT byte boundary and are sized for the channel's
+** sample format. Ring contents are left uninitialized; window lengths are
+** kept where they still fit, sample formats and timestamp intervals are kept.
+*/
+void ofxScopeBuffer::allocate(const std::vector<size_t> &capacities) {
+	std::vector<size_t> windows(capacities.size(), 0);
+	std::vector<double> intervals(capacities.size(), 0);
+	std::vector<ofxScopeSampleFormat> formats(capacities.size());
+	for (int i = 0; i < std::min(capacities.size(), _channels.size()); i++) {
+		windows[i] = std::min(_channels[i].window, capacities[i]);
+		intervals[i] = _channels[i].timestampInterval;
+		formats[i] = _channels[i].format;
+	}
+
+	_channels.assign(capacities.size(), Channel());
+	_history.resize(capacities.size());
+	size_t offset = 0;
+	size_t pyramidOffset = 0;
+	size_t timestampOffset = 0;
+	for (int i = 0; i < _channels.size(); i++) {
+		Channel &c = _channels[i];
+		c.capacity = capacities[i];
+		c.format = formats[i];
+		c.offset = offset;
+		c.written = c.capacity;
+		c.origin = 0;
+		c.claimed = c.written;
+		c.window = windows[i];
+		c.timestampInterval = intervals[i];
+		c.timestampOffset = timestampOffset;
+		offset += floatsFor(c.format, c.capacity);
+		timestampOffset += c.capacity;
+
+		// Level k keeps enough blocks of 2^k samples to cover every block
+		// that lies entirely within the samples held by the ring
+		while (((size_t) 2 << c.nLevels) <= c.capacity) {
+			c.nLevels++;
+		}
+		c.pyramidOffset = pyramidOffset;
+		c.levelOffset.assign(c.nLevels + 1, 0);
+		c.levelBlocks.assign(c.nLevels + 1, 0);
+		size_t pyramidSize = 0;
+		for (int k = 1; k <= c.nLevels; k++) {
+			c.levelOffset[k] = pyramidSize;
+			c.levelBlocks[k] = (c.capacity >> k) + 2;
+			pyramidSize += 2 * c.levelBlocks[k];
+		}
+		pyramidOffset += floatsFor(c.format, pyramidSize);
+	}
+	_arena.allocate(offset);
+	_pyramid.allocate(pyramidOffset);
+	std::fill(_pyramid.data(), _pyramid.data() + pyramidOffset, 0.f);
+	if (_timestamped) {
+		_timestamps.assign(timestampOffset, std::numeric_limits<double>::lowest());
+	}
+}
+
+/*
+** ring
+** Returns the ring storage of a channel.
+*/
+float * ofxScopeBuffer::ring(int channel) {
+	return _arena.data() + _channels[channel].offset;
+}
+
+const float * ofxScopeBuffer::ring(int channel) const {
+	return _arena.data() + _channels[channel].offset;
+}
+
+/*
+** slotOf
+** Returns the ring position of an absolute sample index.
+*/
+size_t ofxScopeBuffer::slotOf(int channel, uint64_t index) const {
+	const Channel &c = _channels[channel];
+	// Only uses fields that stay fixed while samples are pushed, so
+	// ofxScopeView can call it while the writer advances
+	return (size_t) ((index - c.origin) % c.capacity);
+}
+
+/*
+** load
+** Returns the sample at a ring position of a channel as a float.
+*/
+float ofxScopeBuffer::load(int channel, size_t slot) const {
+	return loadSample(_channels[channel].format, ring(channel), slot);
+}
+
+/*
+** store
+** Converts samples to the channel's format and writes them to consecutive
+** ring positions starting at slot, without wrapping.
+*/
+void ofxScopeBuffer::store(int channel, size_t slot, float value) {
+	storeSample(_channels[channel].format, ring(channel), slot, value);
+}
+
+void ofxScopeBuffer::store(int channel, size_t slot, const float * data, size_t nPoints, size_t stride) {
+	const ofxScopeSampleFormat &format = _channels[channel].format;
+	float * dst = ring(channel);
+	if (format.type == ofxScopeSampleFormat::FLOAT32 && stride == 1) {
+		std::copy(data, data + nPoints, dst + slot);
+		return;
+	}
+	size_t j = 0;
+#if defined(OFX_SCOPE_F16C) && defined(__AVX__)
+	if (format.type == ofxScopeSampleFormat::FLOAT16 && stride == 1) {
+		uint16_t * halfs = reinterpret_cast<uint16_t *>(dst) + slot;
+		for (; j + 8 <= nPoints; j += 8) {
+			__m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(data + j), _MM_FROUND_TO_NEAREST_INT);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(halfs + j), h);
+		}
+	}
+#endif
+	for (; j < nPoints; j++) {
+		storeSample(format, dst, slot + j, data[j * stride]);
+	}
+}
+
+void ofxScopeBuffer::store(int channel, size_t slot, const int16_t * codes, size_t nPoints, size_t stride) {
+	const ofxScopeSampleFormat &format = _channels[channel].format;
+	float * dst = ring(channel);
+	if (format.type == ofxScopeSampleFormat::INT16) {
+		// Codes are stored as they are; the scale is applied on reading
+		int16_t * dstCodes = reinterpret_cast<int16_t *>(dst) + slot;
+		for (size_t j = 0; j < nPoints; j++) {
+			dstCodes[j] = codes[j * stride];
+		}
+		return;
+	}
+	for (size_t j = 0; j < nPoints; j++) {
+		storeSample(format, dst, slot + j, codes[j * stride] * format.scale + format.offset);
+	}
+}
+
+/*
+** spill
+** Hands the nPoints oldest samples of a channel, which the next write will
+** overwrite, to the channel's history tier.
+*/
+void ofxScopeBuffer::spill(int channel, size_t nPoints) {
+	ofxScopeHistoryTier * history = _history[channel].get();
+	if (history == NULL) return;
+	const Channel &c = _channels[channel];
+	size_t nEvicted = std::min(nPoints, c.capacity);
+	uint64_t oldest = getOldestIndex(channel);
+	if (c.format.type != ofxScopeSampleFormat::FLOAT32) {
+		// The history holds floats
+		_spillScratch.resize(nEvicted);
+		for (size_t j = 0; j < nEvicted; j++) {
+			_spillScratch[j] = atIndex(channel, oldest + j);
+		}
+		history->append(oldest, _spillScratch.data(), nEvicted);
+		return;
+	}
+	// The oldest sample sits where the next write goes
+	const float * data = ring(channel);
+	size_t nFirst = std::min(nEvicted, c.capacity - c.head);
+	history->append(oldest, data + c.head, nFirst);
+	history->append(oldest + nFirst, data, nEvicted - nFirst);
+}
+
+/*
+** claim
+** Announces that a channel's samples up to absolute index last are about to
+** be written, before any of their ring, pyramid or timestamp storage is
+** touched. The release fence orders the claim before those stores, so a
+** reader that read a slot while it was reused sees the claim after its
+** acquire fence (see ofxScopeView::isIntact).
+*/
+void ofxScopeBuffer::claim(int channel, uint64_t last) {
+	_channels[channel].claimed.store(last, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+/*
+** commit
+** Bookkeeping after nPoints samples were written at the head of a channel:
+** advances the head, stamps the samples and updates the pyramid and the
+** window extremes. timestamps may be NULL, in which case samples are spaced
+** the channel's timestamp interval after the previous one; NaN entries are
+** treated the same way.
+*/
+void ofxScopeBuffer::commit(int channel, size_t nPoints, const double * timestamps) {
+	Channel &c = _channels[channel];
+	c.head = (c.head + nPoints) % c.capacity;
+	c.written += nPoints;
+	uint64_t last = c.written;
+	uint64_t first = last - nPoints;
+
+	if (_timestamped) {
+		double * column = &_timestamps[c.timestampOffset];
+		uint64_t oldest = getOldestIndex(channel);
+		uint64_t n = std::max(first, oldest);
+		double previous = (n > oldest) ?
+			column[slotOf(channel, n - 1)] : std::numeric_limits<double>::lowest();
+		for (; n < last; n++) {
+			double t;
+			if (timestamps != NULL && !std::isnan(timestamps[n - first])) {
+				t = std::max(timestamps[n - first], previous);	// keep timestamps sorted
+			} else {
+				t = (previous == std::numeric_limits<double>::lowest()) ? 0 : previous + c.timestampInterval;
+			}
+			column[slotOf(channel, n)] = t;
+			previous = t;
+		}
+	}
+
+	updatePyramid(channel, first, last);
+	updateWindow(channel, first, last);
+}
+
+/*
+** pyramidSlot
+** Returns the position of the min of an absolute block index at a pyramid
+** level within the channel's pyramid; the max follows it.
+*/
+size_t ofxScopeBuffer::pyramidSlot(int channel, int level, uint64_t block) const {
+	const Channel &c = _channels[channel];
+	return c.levelOffset[level] + 2 * (size_t) (block % c.levelBlocks[level]);
+}
+
+/*
+** getPyramidBlock / setPyramidBlock
+** Read and write the [min, max] pair of a pyramid block, which is stored in
+** the channel's sample format. Extremes of stored samples convert exactly.
+*/
+void ofxScopeBuffer::getPyramidBlock(int channel, int level, uint64_t block, float &min, float &max) const {
+	const Channel &c = _channels[channel];
+	const float * pyramid = _pyramid.data() + c.pyramidOffset;
+	size_t slot = pyramidSlot(channel, level, block);
+	min = loadSample(c.format, pyramid, slot);
+	max = loadSample(c.format, pyramid, slot + 1);
+}
+
+void ofxScopeBuffer::setPyramidBlock(int channel, int level, uint64_t block, float min, float max) {
+	const Channel &c = _channels[channel];
+	float * pyramid = _pyramid.data() + c.pyramidOffset;
+	size_t slot = pyramidSlot(channel, level, block);
+	storeSample(c.format, pyramid, slot, min);
+	storeSample(c.format, pyramid, slot + 1, max);
+}
+
+/*
+** updatePyramid
+** Folds the samples with absolute indexes [first, last) into the pyramid.
+** A block is written once its last sample arrives, by merging its two
+** children, so each sample costs O(1) amortized. Blocks that start before
+** the oldest held sample are skipped; queries never use them.
+*/
+void ofxScopeBuffer::updatePyramid(int channel, uint64_t first, uint64_t last) {
+	int nLevels = _channels[channel].nLevels;
+	if (nLevels == 0) return;
+	uint64_t oldest = last - _channels[channel].capacity;
+	if (first < oldest) first = oldest;
+	for (uint64_t n = first | 1; n < last; n += 2) {
+		// n is the last sample of a level 1 block
+		if (n - 1 < oldest) continue;
+		float a = atIndex(channel, n - 1);
+		float b = atIndex(channel, n);
+		setPyramidBlock(channel, 1, n >> 1, std::min(a, b), std::max(a, b));
+
+		for (int k = 2; k <= nLevels; k++) {
+			uint64_t size = (uint64_t) 1 << k;
+			if (((n + 1) & (size - 1)) != 0) break;
+			if (n + 1 - size < oldest) break;
+			uint64_t blockIndex = n >> k;
+			float loMin, loMax, hiMin, hiMax;
+			getPyramidBlock(channel, k - 1, 2 * blockIndex, loMin, loMax);
+			getPyramidBlock(channel, k - 1, 2 * blockIndex + 1, hiMin, hiMax);
+			setPyramidBlock(channel, k, blockIndex, std::min(loMin, hiMin), std::max(loMax, hiMax));
+		}
+	}
+}
+
+/*
+** rebuildPyramid
+** Recomputes the pyramid of a channel from the samples held in the ring.
+*/
+void ofxScopeBuffer::rebuildPyramid(int channel) {
+	updatePyramid(channel, getOldestIndex(channel), _channels[channel].written);
+}
+
+/*
+** updateWindow
+** Pushes the samples with absolute indexes [first, last) into the window
+** extremum queues and evicts the ones that fell out of the window.
+*/
+void ofxScopeBuffer::updateWindow(int channel, uint64_t first, uint64_t last) {
+	Channel &c = _channels[channel];
+	if (c.window == 0 && !_timestamped) return;
+	uint64_t oldest = windowStart(channel);
+	if (first < oldest) first = oldest;
+	for (uint64_t n = first; n < last; n++) {
+		float v = atIndex(channel, n);
+		c.windowMin.push(n, v);
+		c.windowMax.push(n, v);
+	}
+	c.windowMin.evict(oldest);
+	c.windowMax.evict(oldest);
+}
+
+/*
+** rebuildWindow
+** Recomputes the window extremum queues of a channel from the ring.
+*/
+void ofxScopeBuffer::rebuildWindow(int channel) {
+	Channel &c = _channels[channel];
+	c.windowMin.clear();
+	c.windowMax.clear();
+	c.windowStart = getOldestIndex(channel);
+	updateWindow(channel, getOldestIndex(channel), c.written);
+}
+
+/*
+** windowStart
+** Returns the oldest absolute index inside the window of a channel. With
+** timestamps this is the first sample within _timeWindow seconds of the
+** newest one; the start only moves forward, so advancing it is O(1) amortized.
+*/
+uint64_t ofxScopeBuffer::windowStart(int channel) {
+	Channel &c = _channels[channel];
+	if (!_timestamped) {
+		return c.written - c.window;
+	}
+	c.windowStart = std::max(c.windowStart, getOldestIndex(channel));
+	double oldestTime = getNewestTimestamp(channel) - _timeWindow;
+	while (c.windowStart < c.written && timestampAtIndex(channel, c.windowStart) < oldestTime) {
+		c.windowStart++;
+	}
+	return c.windowStart;
+}
+
+/*
+** setWindow
+** Sets how many of the newest samples getWindowMinMax covers (at most the capacity).
+*/
+void ofxScopeBuffer::setWindow(size_t window) {
+	for (int i = 0; i < _channels.size(); i++) {
+		setWindow(i, window);
+	}
+}
+
+void ofxScopeBuffer::setWindow(int channel, size_t window) {
+	_channels[channel].window = std::min(window, _channels[channel].capacity);
+	rebuildWindow(channel);
+}
+
+/*
+** setTimestamped
+** Enables or disables the timestamp column. Samples already held are given
+** the lowest possible timestamp so they fall outside any time window.
+*/
+void ofxScopeBuffer::setTimestamped(bool timestamped, double interval) {
+	for (int i = 0; i < _channels.size(); i++) {
+		_channels[i].timestampInterval = interval;
+	}
+	if (timestamped == _timestamped) return;
+	_timestamped = timestamped;
+	_timestamps.clear();
+	if (_timestamped) {
+		size_t nTimestamps = 0;
+		for (int i = 0; i < _channels.size(); i++) {
+			nTimestamps += _channels[i].capacity;
+		}
+		_timestamps.assign(nTimestamps, std::numeric_limits<double>::lowest());
+	}
+	for (int i = 0; i < _channels.size(); i++) {
+		rebuildWindow(i);
+	}
+}
+
+/*
+** setTimestampInterval
+** Sets the spacing of samples pushed to a channel without timestamps.
+*/
+void ofxScopeBuffer::setTimestampInterval(int channel, double interval) {
+	_channels[channel].timestampInterval = interval;
+}
+
+/*
+** setTimeWindow
+** Sets how many seconds getWindowMinMax covers when timestamped.
+*/
+void ofxScopeBuffer::setTimeWindow(double seconds) {
+	_timeWindow = seconds;
+	if (_timestamped) {
+		for (int i = 0; i < _channels.size(); i++) {
+			rebuildWindow(i);
+		}
+	}
+}
+
+bool ofxScopeBuffer::isTimestamped() const {
+	return _timestamped;
+}
+
+/*
+** setHistory
+** Attaches a history tier that receives the samples of a channel as the
+** ring evicts them. Pass NULL to detach.
+*/
+void ofxScopeBuffer::setHistory(int channel, std::shared_ptr<ofxScopeHistoryTier> history) {
+	_history[channel] = history;
+}
+
+const ofxScopeHistoryTier * ofxScopeBuffer::getHistory(int channel) const {
+	return _history[channel].get();
+}
+
+/*
+** setSampleFormat
+** Changes the storage format of a channel, converting the samples it holds.
+** Absolute indexes stay continuous.
+*/
+void ofxScopeBuffer::setSampleFormat(int channel, const ofxScopeSampleFormat &format) {
+	ofxScopeSampleFormat &current = _channels[channel].format;
+	if (format.type == current.type && format.scale == current.scale && format.offset == current.offset) {
+		return;
+	}
+	std::vector<size_t> capacities(_channels.size());
+	for (int i = 0; i < _channels.size(); i++) {
+		capacities[i] = _channels[i].capacity;
+	}
+	ofxScopeBuffer previous = *this;
+	current = format;
+	reallocate(capacities, previous);
+}
+
+const ofxScopeSampleFormat & ofxScopeBuffer::getSampleFormat(int channel) const {
+	return _channels[channel].format;
+}
+
+/*
+** setup
+** Allocates nChannels ring buffers holding capacity samples each.
+** Every slot is initialized to fillValue so the buffer always reads as full.
+*/
+void ofxScopeBuffer::setup(int nChannels, size_t capacity, float fillValue) {
+	setup(std::vector<size_t>(nChannels, capacity), fillValue);
+}
+
+/*
+** setup
+** Allocates one ring buffer per entry of capacities.
+*/
+void ofxScopeBuffer::setup(const std::vector<size_t> &capacities, float fillValue) {
+	allocate(capacities);
+	// Indexes restart, so histories of the previous samples no longer line up
+	_history.assign(_channels.size(), std::shared_ptr<ofxScopeHistoryTier>());
+	for (int i = 0; i < _channels.size(); i++) {
+		fill(i, fillValue);
+	}
+}
+
+/*
+** resize
+** Changes the capacity of every channel. The newest samples are kept
+** and the oldest end is padded with zeros when growing.
+*/
+void ofxScopeBuffer::resize(size_t capacity) {
+	resize(std::vector<size_t>(_channels.size(), capacity));
+}
+
+void ofxScopeBuffer::resize(const std::vector<size_t> &capacities) {
+	bool changed = capacities.size() != _channels.size();
+	for (int i = 0; !changed && i < _channels.size(); i++) {
+		changed = capacities[i] != _channels[i].capacity;
+	}
+	if (!changed) return;
+
+	ofxScopeBuffer previous = *this;
+	reallocate(capacities, previous);
+}
+
+/*
+** reallocate
+** Allocates storage for capacities and copies the newest samples of each
+** channel over from previous, converting them to the channel's format.
+*/
+void ofxScopeBuffer::reallocate(const std::vector<size_t> &capacities, const ofxScopeBuffer &previous) {
+	allocate(capacities);
+	for (int i = 0; i < _channels.size(); i++) {
+		Channel &c = _channels[i];
+		if (i >= previous._channels.size()) {
+			fill(i, 0.f);
+			continue;
+		}
+		const Channel &p = previous._channels[i];
+		size_t nKeep = std::min(c.capacity, p.capacity);
+		for (size_t slot = 0; slot < c.capacity - nKeep; slot++) {
+			store(i, slot, 0.f);
+		}
+		// Copy oldest to newest so the newest sample lands in the last slot
+		for (size_t age = 0; age < nKeep; age++) {
+			store(i, c.capacity - 1 - age, previous.at(i, age));
+		}
+		if (_timestamped) {
+			double * column = &_timestamps[c.timestampOffset];
+			for (size_t age = 0; age < nKeep; age++) {
+				column[c.capacity - 1 - age] = previous.timestampAtIndex(i, p.written - 1 - age);
+			}
+		}
+		// Keep absolute indexes continuous where the zero padding allows it
+		c.written = std::max(p.written, (uint64_t) c.capacity);
+		c.origin = c.written - c.capacity;
+		c.claimed = c.written;
+		rebuildPyramid(i);
+		rebuildWindow(i);
+	}
+}
+
+/*
+** push
+** Appends one sample to a channel, overwriting the oldest sample.
+*/
+void ofxScopeBuffer::push(int channel, float value) {
+	if (_channels[channel].capacity == 0) return;
+	spill(channel, 1);
+	claim(channel, _channels[channel].written + 1);
+	store(channel, _channels[channel].head, value);
+	commit(channel, 1, NULL);
+}
+
+/*
+** pushCode
+** Appends one raw INT16 code to a channel, see push(channel, codes, ...).
+*/
+void ofxScopeBuffer::pushCode(int channel, int16_t code) {
+	if (_channels[channel].capacity == 0) return;
+	spill(channel, 1);
+	claim(channel, _channels[channel].written + 1);
+	store(channel, _channels[channel].head, &code, 1, 1);
+	commit(channel, 1, NULL);
+}
+
+/*
+** push
+** Appends nPoints samples (oldest first) to a channel, reading every
+** stride-th float of data. Only the newest samples that fit are retained.
+*/
+void ofxScopeBuffer::push(int channel, const float * data, size_t nPoints, size_t stride) {
+	push(channel, data, NULL, nPoints, stride);
+}
+
+/*
+** push
+** Appends nPoints samples (oldest first) with their timestamps in seconds.
+** timestamps may be NULL. Timestamps are ignored if the buffer isn't
+** timestamped, and are clamped so they never decrease.
+*/
+void ofxScopeBuffer::push(int channel, const float * data, const double * timestamps,
+	size_t nPoints, size_t stride) {
+	pushSamples(channel, data, timestamps, nPoints, stride);
+}
+
+/*
+** push
+** Appends nPoints raw INT16 codes (oldest first), reading every stride-th
+** code. INT16 channels store them unconverted; other formats store
+** code * scale + offset of the channel's format.
+*/
+void ofxScopeBuffer::push(int channel, const int16_t * codes, size_t nPoints, size_t stride) {
+	pushSamples(channel, codes, (const double *) NULL, nPoints, stride);
+}
+
+/*
+** pushSamples
+** Shared body of the bulk pushes for float values and INT16 codes.
+*/
+template <class T>
+void ofxScopeBuffer::pushSamples(int channel, const T * data, const double * timestamps,
+	size_t nPoints, size_t stride) {
+	size_t capacity = _channels[channel].capacity;
+	if (capacity == 0 || nPoints == 0) return;
+	while (nPoints > capacity && _history[channel]) {
+		// Every sample must pass through the ring on its way to the history
+		pushSamples(channel, data, timestamps, capacity, stride);
+		data += capacity * stride;
+		if (timestamps != NULL) timestamps += capacity;
+		nPoints -= capacity;
+	}
+	if (nPoints > capacity) {
+		data += (nPoints - capacity) * stride;
+		if (timestamps != NULL) timestamps += nPoints - capacity;
+		nPoints = capacity;
+	}
+	spill(channel, nPoints);
+	claim(channel, _channels[channel].written + nPoints);
+	size_t head = _channels[channel].head;
+	size_t nFirst = std::min(nPoints, capacity - head);
+	store(channel, head, data, nFirst, stride);
+	store(channel, 0, data + nFirst * stride, nPoints - nFirst, stride);
+	commit(channel, nPoints, timestamps);
+}
+
+/*
+** pushInterleaved
+** Appends nFrames interleaved frames [f0: ch0..chN-1][f1: ch0..chN-1]...
+** (oldest first), deinterleaving directly into each channel's ring storage.
+** Returns false without writing anything if nChannels does not match.
+*/
+bool ofxScopeBuffer::pushInterleaved(const float * frames, size_t nFrames, int nChannels) {
+	if (nChannels != _channels.size()) return false;
+	size_t maxCapacity = 0;
+	bool deinterleave = true;
+	for (int c = 0; c < nChannels; c++) {
+		if (_channels[c].capacity == 0) return true;
+		maxCapacity = std::max(maxCapacity, _channels[c].capacity);
+		deinterleave = deinterleave && !_history[c] &&
+			_channels[c].format.type == ofxScopeSampleFormat::FLOAT32;
+	}
+	if (!deinterleave) {
+		// Strided pushes convert every sample and spill it on its way through the rings
+		for (int c = 0; c < nChannels; c++) {
+			push(c, frames + c, nFrames, nChannels);
+		}
+		return true;
+	}
+	if (nFrames > maxCapacity) {
+		frames += (nFrames - maxCapacity) * nChannels;
+		nFrames = maxCapacity;
+	}
+
+	std::vector<float *> &dst = _writePointers;
+	dst.resize(nChannels);
+	while (nFrames > 0) {
+		// Largest run of frames that doesn't wrap in any channel
+		size_t run = nFrames;
+		for (int c = 0; c < nChannels; c++) {
+			run = std::min(run, _channels[c].capacity - _channels[c].head);
+		}
+		for (int c = 0; c < nChannels; c++) {
+			claim(c, _channels[c].written + run);
+			dst[c] = ring(c) + _channels[c].head;
+		}
+		ofxScopeDeinterleave(frames, run, nChannels, dst.data());
+		for (int c = 0; c < nChannels; c++) {
+			commit(c, run, NULL);
+		}
+		frames += run * nChannels;
+		nFrames -= run;
+	}
+	return true;
+}
+
+/*
+** pushFrame
+** Appends one frame holding a sample for each channel, as float values or
+** raw INT16 codes (see push(channel, codes, ...)). Every channel's sample is
+** written to its ring first, then the bookkeeping runs over the frame.
+** Returns false without writing anything if nChannels does not match.
+*/
+bool ofxScopeBuffer::pushFrame(const float * frame, int nChannels) {
+	return pushFrameSamples(frame, nChannels);
+}
+
+bool ofxScopeBuffer::pushFrame(const int16_t * frame, int nChannels) {
+	return pushFrameSamples(frame, nChannels);
+}
+
+/*
+** pushFrameSamples
+** Shared body of pushFrame for float values and INT16 codes.
+*/
+template <class T>
+bool ofxScopeBuffer::pushFrameSamples(const T * frame, int nChannels) {
+	if (nChannels != _channels.size()) return false;
+	for (int c = 0; c < nChannels; c++) {
+		if (_channels[c].capacity == 0) return true;
+	}
+	for (int c = 0; c < nChannels; c++) {
+		spill(c, 1);
+		claim(c, _channels[c].written + 1);
+		store(c, _channels[c].head, frame + c, 1, 1);
+	}
+	for (int c = 0; c < nChannels; c++) {
+		commit(c, 1, NULL);
+	}
+	return true;
+}
+
+/*
+** fill
+** Sets every sample of a channel to value.
+*/
+void ofxScopeBuffer::fill(int channel, float value) {
+	claim(channel, _channels[channel].written + _channels[channel].capacity);
+	for (size_t slot = 0; slot < _channels[channel].capacity; slot++) {
+		store(channel, slot, value);
+	}
+	rebuildPyramid(channel);
+	rebuildWindow(channel);
+}
+
+/*
+** at
+** Returns the sample of a channel at a given age (0 is the newest sample).
+*/
+float ofxScopeBuffer::at(int channel, size_t age) const {
+	const Channel &c = _channels[channel];
+	size_t index = (c.head > age) ? c.head - 1 - age : c.head + c.capacity - 1 - age;
+	return load(channel, index);
+}
+
+/*
+** newest
+** Returns the most recently appended sample of a channel.
+*/
+float ofxScopeBuffer::newest(int channel) const {
+	return at(channel, 0);
+}
+
+/*
+** atIndex
+** Returns the sample of a channel with a given absolute index.
+** index must lie within [getOldestIndex(), getNumWritten()).
+*/
+float ofxScopeBuffer::atIndex(int channel, uint64_t index) const {
+	return load(channel, slotOf(channel, index));
+}
+
+/*
+** codeAtIndex
+** Returns the stored code of a sample: the raw code of an INT16 channel,
+** the value itself otherwise. The value is code * scale + offset of the
+** channel's format, so renderers can fold the conversion into their own
+** transform.
+*/
+float ofxScopeBuffer::codeAtIndex(int channel, uint64_t index) const {
+	const Channel &c = _channels[channel];
+	if (c.format.type == ofxScopeSampleFormat::INT16) {
+		return reinterpret_cast<const int16_t *>(ring(channel))[slotOf(channel, index)];
+	}
+	return atIndex(channel, index);
+}
+
+/*
+** timestampAtIndex
+** Returns the timestamp (seconds) of a sample with a given absolute index.
+** The buffer must be timestamped.
+*/
+double ofxScopeBuffer::timestampAtIndex(int channel, uint64_t index) const {
+	return _timestamps[_channels[channel].timestampOffset + slotOf(channel, index)];
+}
+
+/*
+** getNewestTimestamp
+** Returns the timestamp of the newest sample of a channel.
+*/
+double ofxScopeBuffer::getNewestTimestamp(int channel) const {
+	return timestampAtIndex(channel, _channels[channel].written - 1);
+}
+
+/*
+** findIndex
+** Binary searches the held samples of a timestamped channel for the first
+** absolute index whose timestamp is >= timestamp. Returns getNumWritten()
+** if every held sample is older.
+*/
+uint64_t ofxScopeBuffer::findIndex(int channel, double timestamp) const {
+	return findIndexIn(channel, getOldestIndex(channel), _channels[channel].written, timestamp);
+}
+
+/*
+** findIndexIn
+** findIndex restricted to the held absolute indexes [lo, hi).
+*/
+uint64_t ofxScopeBuffer::findIndexIn(int channel, uint64_t lo, uint64_t hi, double timestamp) const {
+	while (lo < hi) {
+		uint64_t mid = lo + (hi - lo) / 2;
+		if (timestampAtIndex(channel, mid) < timestamp) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/*
+** getNumWritten
+** Returns the absolute index the next appended sample of a channel will get.
+** The initial fill occupies indexes [0, capacity).
+*/
+uint64_t ofxScopeBuffer::getNumWritten(int channel) const {
+	return _channels[channel].written;
+}
+
+/*
+** getOldestIndex
+** Returns the absolute index of the oldest sample held by a channel.
+*/
+uint64_t ofxScopeBuffer::getOldestIndex(int channel) const {
+	return _channels[channel].written - _channels[channel].capacity;
+}
+
+/*
+** getMinMax
+** Computes the min and max of the samples with absolute indexes [first, last),
+** clipped to the samples held by the ring. Walks the range greedily using the
+** largest aligned pyramid block that fits, so the cost is O(log(last - first)).
+** Returns false if the clipped range is empty.
+*/
+bool ofxScopeBuffer::getMinMax(int channel, uint64_t first, uint64_t last,
+	float &min, float &max) const {
+	first = std::max(first, getOldestIndex(channel));
+	last = std::min(last, _channels[channel].written);
+	if (first >= last) return false;
+	minMaxOf(channel, first, last, min, max);
+	return true;
+}
+
+/*
+** minMaxOf
+** getMinMax of a non-empty range of held samples, without clipping.
+*/
+void ofxScopeBuffer::minMaxOf(int channel, uint64_t first, uint64_t last,
+	float &min, float &max) const {
+	int nLevels = _channels[channel].nLevels;
+	min = atIndex(channel, first);
+	max = min;
+	uint64_t i = first;
+	while (i < last) {
+		int k = 0;
+		while (k < nLevels) {
+			uint64_t size = (uint64_t) 2 << k;
+			if ((i & (size - 1)) != 0 || i + size > last) break;
+			k++;
+		}
+		if (k == 0) {
+			float v = atIndex(channel, i);
+			min = std::min(min, v);
+			max = std::max(max, v);
+			i++;
+		} else {
+			float blockMin, blockMax;
+			getPyramidBlock(channel, k, i >> k, blockMin, blockMax);
+			min = std::min(min, blockMin);
+			max = std::max(max, blockMax);
+			i += (uint64_t) 1 << k;
+		}
+	}
+}
+
+/*
+** getWindowMinMax
+** Returns the min and max of the window of a channel in O(1).
+** Returns false if the window is empty.
+*/
+bool ofxScopeBuffer::getWindowMinMax(int channel, float &min, float &max) const {
+	const Channel &c = _channels[channel];
+	if (c.windowMin.empty()) return false;
+	min = c.windowMin.front();
+	max = c.windowMax.front();
+	return true;
+}
+
+/*
+** channelData
+** Returns the raw ring storage of a channel (capacity samples, not in age order).
+*/
+const float * ofxScopeBuffer::channelData(int channel) const {
+	return ring(channel);
+}
+
+/*
+** getSegments
+** Returns the channel contents as two contiguous segments ordered oldest to newest.
+*/
+void ofxScopeBuffer::getSegments(int channel, const float * &first, size_t &nFirst,
+	const float * &second, size_t &nSecond) const {
+	const float * data = ring(channel);
+	const Channel &c = _channels[channel];
+	first = data + c.head;
+	nFirst = c.capacity - c.head;
+	second = data;
+	nSecond = c.head;
+}
+
+/*
+** getNumChannels
+*/
+int ofxScopeBuffer::getNumChannels() const {
+	return _channels.size();
+}
+
+/*
+** getCapacity
+** Returns the number of samples held by a channel.
+*/
+size_t ofxScopeBuffer::getCapacity(int channel) const {
+	return _channels[channel].capacity;
+}
+
+/*
+** snapshot
+** Captures the per-channel write counters and window extremes so an
+** ofxScopeView can read a consistent frame while pushing continues.
+** Reuses the snapshot's storage; allocates only when the channel count changes.
+*/
+void ofxScopeBuffer::snapshot(ofxScopeSnapshot &snapshot) const {
+	size_t nChannels = _channels.size();
+	snapshot.written.resize(nChannels);
+	snapshot.hasWindow.resize(nChannels);
+	snapshot.windowMin.resize(nChannels);
+	snapshot.windowMax.resize(nChannels);
+	snapshot.newestTimestamp.resize(nChannels);
+	snapshot.timestamped = _timestamped;
+	for (int i = 0; i < nChannels; i++) {
+		snapshot.written[i] = _channels[i].written;
+		snapshot.hasWindow[i] = getWindowMinMax(i, snapshot.windowMin[i], snapshot.windowMax[i]);
+		snapshot.newestTimestamp[i] = (_timestamped && _channels[i].capacity > 0) ?
+			getNewestTimestamp(i) : std::numeric_limits<double>::lowest();
+	}
+}
+
+/*-------------------------------------------------
+* ofxScopeView
+*-------------------------------------------------*/
+
+/*
+** ofxScopeView
+** buffer and snapshot must outlive the view.
+*/
+ofxScopeView::ofxScopeView(const ofxScopeBuffer &buffer, const ofxScopeSnapshot &snapshot) {
+	_buffer = &buffer;
+	_snapshot = &snapshot;
+}
+
+int ofxScopeView::getNumChannels() const {
+	return _snapshot->written.size();
+}
+
+size_t ofxScopeView::getCapacity(int channel) const {
+	return _buffer->_channels[channel].capacity;
+}
+
+const ofxScopeSampleFormat & ofxScopeView::getSampleFormat(int channel) const {
+	return _buffer->_channels[channel].format;
+}
+
+bool ofxScopeView::isTimestamped() const {
+	return _snapshot->timestamped;
+}
+
+uint64_t ofxScopeView::getGeneration() const {
+	return _snapshot->generation;
+}
+
+/*
+** at
+** Returns the sample of a channel at a given age relative to the snapshot.
+*/
+float ofxScopeView::at(int channel, size_t age) const {
+	return atIndex(channel, _snapshot->written[channel] - 1 - age);
+}
+
+float ofxScopeView::atIndex(int channel, uint64_t index) const {
+	if (index < ringOldest(channel)) {
+		return _buffer->getHistory(channel)->at(index);
+	}
+	return _buffer->atIndex(channel, index);
+}
+
+/*
+** codeAtIndex
+** ofxScopeBuffer::codeAtIndex; samples read from the history tier are
+** converted back to codes.
+*/
+float ofxScopeView::codeAtIndex(int channel, uint64_t index) const {
+	if (index < ringOldest(channel)) {
+		const ofxScopeSampleFormat &format = getSampleFormat(channel);
+		return (_buffer->getHistory(channel)->at(index) - format.offset) / format.scale;
+	}
+	return _buffer->codeAtIndex(channel, index);
+}
+
+uint64_t ofxScopeView::getNumWritten(int channel) const {
+	return _snapshot->written[channel];
+}
+
+/*
+** getOldestIndex
+** Returns the oldest readable index: the oldest sample of the history tier
+** if one is attached and reaches the ring, otherwise of the ring.
+*/
+uint64_t ofxScopeView::getOldestIndex(int channel) const {
+	uint64_t oldest = ringOldest(channel);
+	const ofxScopeHistoryTier * history = _buffer->getHistory(channel);
+	if (history != NULL && history->getEndIndex() >= oldest) {
+		oldest = std::min(oldest, history->getFirstIndex());
+	}
+	return oldest;
+}
+
+/*
+** ringOldest
+** Returns the oldest index held by the ring as of the snapshot.
+*/
+uint64_t ofxScopeView::ringOldest(int channel) const {
+	return _snapshot->written[channel] - _buffer->_channels[channel].capacity;
+}
+
+/*
+** getMinMax
+** ofxScopeBuffer::getMinMax clipped to the samples held as of the snapshot.
+*/
+bool ofxScopeView::getMinMax(int channel, uint64_t first, uint64_t last,
+	float &min, float &max) const {
+	first = std::max(first, getOldestIndex(channel));
+	last = std::min(last, getNumWritten(channel));
+	if (first >= last) return false;
+
+	// Part of the range older than the ring comes from the history tier
+	uint64_t oldest = ringOldest(channel);
+	bool found = false;
+	if (first < oldest) {
+		found = _buffer->getHistory(channel)->getMinMax(first, std::min(last, oldest), min, max);
+		first = oldest;
+	}
+	if (first < last) {
+		float ringMin, ringMax;
+		_buffer->minMaxOf(channel, first, last, ringMin, ringMax);
+		min = found ? std::min(min, ringMin) : ringMin;
+		max = found ? std::max(max, ringMax) : ringMax;
+		found = true;
+	}
+	return found;
+}
+
+bool ofxScopeView::getWindowMinMax(int channel, float &min, float &max) const {
+	if (!_snapshot->hasWindow[channel]) return false;
+	min = _snapshot->windowMin[channel];
+	max = _snapshot->windowMax[channel];
+	return true;
+}
+
+double ofxScopeView::timestampAtIndex(int channel, uint64_t index) const {
+	return _buffer->timestampAtIndex(channel, index);
+}
+
+double ofxScopeView::getNewestTimestamp(int channel) const {
+	return _snapshot->newestTimestamp[channel];
+}
+
+uint64_t ofxScopeView::findIndex(int channel, double timestamp) const {
+	// Timestamps are only kept for the ring
+	return _buffer->findIndexIn(channel, ringOldest(channel), getNumWritten(channel), timestamp);
+}
+
+/*
+** isIntact
+** Returns true if what was read through the view from index first on, up to
+** now, cannot have been overwritten while it was read. Call after reading.
+*/
+bool ofxScopeView::isIntact(int channel, uint64_t first) const {
+	return first >= getIntactOldest(channel);
+}
+
+/*
+** getIntactOldest
+** Returns the oldest index whose reads through the view, up to now, cannot
+** have been overwritten: ring samples whose slots the writer has not claimed
+** since the snapshot, and history samples not yet recycled. The acquire fence
+** pairs with the writer's release fence after each claim, seqlock style.
+*/
+uint64_t ofxScopeView::getIntactOldest(int channel) const {
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const ofxScopeBuffer::Channel &c = _buffer->_channels[channel];
+	uint64_t claimed = c.claimed.load(std::memory_order_relaxed);
+	uint64_t oldest = ringOldest(channel);
+	if (claimed > oldest + c.capacity) {
+		// Slots of the oldest samples of the snapshot were reused
+		return claimed - c.capacity;
+	}
+	const ofxScopeHistoryTier * history = _buffer->getHistory(channel);
+	if (history != NULL && history->getEndIndex() >= oldest) {
+		oldest = std::min(oldest, history->getFirstIndex());
+	}
+	return oldest;
+}
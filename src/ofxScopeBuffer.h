@@ -0,0 +1,409 @@
+//
+//  ofxScopeBuffer.h
+//
+//  Circular sample storage for ofxScopePlot
+//
+//  This work is licensed under the Creative Commons
+//  Attribution-ShareAlike 3.0 Unported License.
+//  To view a copy of this license, visit http://creativecommons.org/licenses/by-sa/3.0/.
+//
+
+#ifndef _OFX_SCOPE_BUFFER
+#define _OFX_SCOPE_BUFFER
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "ofxScopeHistory.h"
+
+#define OFX_SCOPE_BUFFER_ALIGNMENT 64	// Bytes; one cache line
+
+/*-------------------------------------------------
+* ofxScopeSpan
+* Non-owning view of nPoints samples in caller memory,
+* spaced stride floats apart. Used to hand data to
+* ofxScopePlot::updateData without intermediate copies.
+*-------------------------------------------------*/
+struct ofxScopeSpan {
+	const float * data;
+	size_t size;
+	size_t stride;
+
+	ofxScopeSpan() : data(NULL), size(0), stride(1) {}
+	ofxScopeSpan(const float * data, size_t size, size_t stride = 1) : data(data), size(size), stride(stride) {}
+	ofxScopeSpan(const std::vector<float> &data) : data(data.data()), size(data.size()), stride(1) {}
+
+	float operator[](size_t i) const { return data[i * stride]; }
+};
+
+/*-------------------------------------------------
+* ofxScopeAtomic
+* std::atomic that can be copied, for state shared
+* between the updating and the render thread of a
+* class that keeps its copy semantics. Copying loads
+* the value and is not thread safe itself.
+*-------------------------------------------------*/
+template <class T>
+class ofxScopeAtomic : public std::atomic<T> {
+public:
+	ofxScopeAtomic(T value = T()) : std::atomic<T>(value) {}
+	ofxScopeAtomic(const ofxScopeAtomic &other) : std::atomic<T>(other.load(std::memory_order_relaxed)) {}
+	ofxScopeAtomic& operator=(const ofxScopeAtomic &other) {
+		this->store(other.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		return *this;
+	}
+	using std::atomic<T>::operator=;
+};
+
+/*
+** ofxScopeDeinterleave
+** Splits nFrames interleaved frames [f0: ch0..chN-1][f1: ch0..chN-1]...
+** into nChannels contiguous destination arrays dst[ch][nFrames].
+** Uses SSE/AVX2/NEON kernels for common channel counts with a scalar fallback.
+*/
+void ofxScopeDeinterleave(const float * src, size_t nFrames, int nChannels, float * const * dst);
+
+/*-------------------------------------------------
+* ofxScopeSampleFormat
+* Storage format of one ofxScopeBuffer channel.
+* FLOAT16 and INT16 take half the memory of FLOAT32
+* for the ring and its min/max pyramid. INT16 keeps
+* integer codes, e.g. straight from an ADC, that read
+* back as code * scale + offset; values pushed as
+* floats are rounded to the nearest code and clamped.
+*-------------------------------------------------*/
+struct ofxScopeSampleFormat {
+	enum Type {
+		FLOAT32,
+		FLOAT16,
+		INT16
+	};
+
+	Type type;
+	float scale;	// Value of one code step (INT16 only, otherwise 1)
+	float offset;	// Value of code 0 (INT16 only, otherwise 0)
+
+	ofxScopeSampleFormat(Type type = FLOAT32, float scale = 1.f, float offset = 0.f) : type(type),
+		scale(type == INT16 ? scale : 1.f), offset(type == INT16 ? offset : 0.f) {}
+
+	size_t getSampleSize() const { return type == FLOAT32 ? 4 : 2; }	// Bytes per sample
+};
+
+/*-------------------------------------------------
+* ofxScopeAlignedArray
+* Owning array of floats aligned to
+* OFX_SCOPE_BUFFER_ALIGNMENT bytes. Copies are deep.
+* ofxScopeBuffer also packs 16 bit samples into it.
+*-------------------------------------------------*/
+class ofxScopeAlignedArray {
+private:
+	void * _allocation;		// Unaligned block returned by the allocator
+	float * _data;
+	size_t _size;
+
+public:
+	ofxScopeAlignedArray();
+	ofxScopeAlignedArray(const ofxScopeAlignedArray &other);
+	ofxScopeAlignedArray& operator=(const ofxScopeAlignedArray &other);
+	~ofxScopeAlignedArray();
+
+	void allocate(size_t size);		// Contents are left uninitialized
+	float * data() { return _data; }
+	const float * data() const { return _data; }
+	size_t size() const { return _size; }
+};
+
+/*-------------------------------------------------
+* ofxScopeMonotonicQueue
+* Sliding window extremum of a stream of samples.
+* Holds (index, value) pairs whose values are strictly
+* decreasing (max queue) or increasing (min queue) from
+* front to back, so the front is always the extremum of
+* the window. Push and evict are O(1) amortized. Storage
+* is a ring that grows by doubling only as needed.
+*-------------------------------------------------*/
+class ofxScopeMonotonicQueue {
+private:
+	std::vector<uint64_t> _index;
+	std::vector<float> _value;
+	size_t _front;
+	size_t _count;
+	bool _isMax;
+
+	void grow();
+
+public:
+	ofxScopeMonotonicQueue(bool isMax = true);
+
+	void clear();
+	void push(uint64_t index, float value);
+	void evict(uint64_t oldestIndex);	// Drops entries with index < oldestIndex
+	bool empty() const;
+	float front() const;				// Extremum of the window
+};
+
+/*-------------------------------------------------
+* ofxScopeSnapshot
+* Per-channel counters and window extremes of an
+* ofxScopeBuffer at one point in time. Small enough
+* to capture after every update; see ofxScopeView.
+*-------------------------------------------------*/
+struct ofxScopeSnapshot {
+	std::vector<uint64_t> written;		// Absolute index of the next sample
+	std::vector<char> hasWindow;		// Whether windowMin/windowMax are valid
+	std::vector<float> windowMin;
+	std::vector<float> windowMax;
+	std::vector<double> newestTimestamp;
+	bool timestamped;
+	uint64_t generation;	// Set by the publisher; changes whenever the published state does
+
+	ofxScopeSnapshot() : timestamped(false), generation(0) {}
+};
+
+/*-------------------------------------------------
+* ofxScopeBuffer
+* Per-channel ring buffers holding the most recent
+* samples of each variable plotted by ofxScopePlot.
+* Appending is O(1) per sample; samples are addressed
+* by age where age 0 is the newest sample.
+*
+* All channels live in a single cache line aligned
+* allocation (structure of arrays). Each channel starts
+* on its own cache line and may have its own capacity,
+* so channels sampled at different rates only take the
+* memory they need.
+*
+* Every appended sample also gets an absolute index
+* (0, 1, 2, ... per channel) and updates a min/max
+* pyramid: level k holds the min and max of aligned
+* blocks of 2^k samples, so the extremes of any range
+* are found in O(log n) without visiting each sample.
+*
+* The min and max of the newest window samples are
+* additionally tracked with monotonic queues, giving
+* O(1) window extremes for autoscaling.
+*
+* Each channel stores its ring and pyramid in its own
+* ofxScopeSampleFormat; samples are converted on
+* access, so every reader sees floats.
+*
+* A channel may have an ofxScopeHistoryTier attached;
+* samples are appended to it just before the ring
+* overwrites them, so history and ring together hold
+* every sample. Copies share the history tier.
+*
+* Optionally a timestamp (seconds) is stored alongside
+* every sample. Timestamps are kept non-decreasing so
+* time ranges can be located by binary search, and the
+* window extremes then cover the newest _timeWindow
+* seconds instead of a fixed number of samples.
+*-------------------------------------------------*/
+class ofxScopeBuffer {
+private:
+	struct Channel {
+		size_t capacity;			// Samples held
+		ofxScopeSampleFormat format;	// Storage format of the ring and pyramid
+		size_t offset;				// Start of the ring within _arena (floats, aligned)
+		size_t head;				// Ring position of the next write
+		uint64_t written;			// Absolute index of the next sample
+		uint64_t origin;			// Absolute index stored at ring position 0 (fixed until reallocated)
+		ofxScopeAtomic<uint64_t> claimed;	// Index after the newest sample being written; see claim
+
+		// Min/max pyramid
+		int nLevels;						// Highest level; level 0 is the raw samples
+		size_t pyramidOffset;				// Start of the pyramid within _pyramid (floats)
+		std::vector<size_t> levelOffset;	// Offset of each level within the pyramid (samples)
+		std::vector<size_t> levelBlocks;	// Number of blocks kept per level
+
+		// Sliding window extremes
+		size_t window;						// Samples covered by the window extremes
+		uint64_t windowStart;				// Oldest absolute index inside the window (timestamped)
+		ofxScopeMonotonicQueue windowMin;
+		ofxScopeMonotonicQueue windowMax;
+
+		size_t timestampOffset;				// Start of the timestamp ring within _timestamps
+		double timestampInterval;			// Spacing given to samples pushed without timestamps
+
+		Channel() : capacity(0), offset(0), head(0), written(0), origin(0), nLevels(0), pyramidOffset(0),
+			window(0), windowStart(0), windowMin(false), windowMax(true), timestampOffset(0),
+			timestampInterval(0) {}
+	};
+
+	ofxScopeAlignedArray _arena;		// Ring storage of every channel
+	std::vector<Channel> _channels;
+	ofxScopeAlignedArray _pyramid;		// [channel][level][block][min, max]
+	std::vector<float *> _writePointers;	// Scratch destinations for pushInterleaved
+	std::vector<float> _spillScratch;	// Evicted samples converted for the history tier
+	std::vector<std::shared_ptr<ofxScopeHistoryTier> > _history;	// Receives evicted samples; may be NULL
+
+	// Timestamps
+	bool _timestamped;
+	std::vector<double> _timestamps;	// [channel][capacity], parallel to the rings
+	double _timeWindow;					// Seconds covered by the window extremes when timestamped
+
+	void allocate(const std::vector<size_t> &capacities);
+	float * ring(int channel);
+	const float * ring(int channel) const;
+	size_t slotOf(int channel, uint64_t index) const;
+	float load(int channel, size_t slot) const;
+	void store(int channel, size_t slot, float value);
+	void store(int channel, size_t slot, const float * data, size_t nPoints, size_t stride);
+	void store(int channel, size_t slot, const int16_t * codes, size_t nPoints, size_t stride);
+	template <class T> void pushSamples(int channel, const T * data, const double * timestamps,
+		size_t nPoints, size_t stride);
+	template <class T> bool pushFrameSamples(const T * frame, int nChannels);
+	void reallocate(const std::vector<size_t> &capacities, const ofxScopeBuffer &previous);
+	void spill(int channel, size_t nPoints);
+	void claim(int channel, uint64_t last);
+	void commit(int channel, size_t nPoints, const double * timestamps);
+	void updatePyramid(int channel, uint64_t first, uint64_t last);
+	void rebuildPyramid(int channel);
+	void updateWindow(int channel, uint64_t first, uint64_t last);
+	void rebuildWindow(int channel);
+	uint64_t windowStart(int channel);
+	size_t pyramidSlot(int channel, int level, uint64_t block) const;
+	void getPyramidBlock(int channel, int level, uint64_t block, float &min, float &max) const;
+	void setPyramidBlock(int channel, int level, uint64_t block, float min, float max);
+	void minMaxOf(int channel, uint64_t first, uint64_t last, float &min, float &max) const;
+	uint64_t findIndexIn(int channel, uint64_t lo, uint64_t hi, double timestamp) const;
+
+	friend class ofxScopeView;
+
+public:
+
+	// Constructors
+	ofxScopeBuffer();
+	// Destructor
+	~ofxScopeBuffer();
+
+	// Setup
+	void setup(int nChannels, size_t capacity, float fillValue = 0.f);
+	void setup(const std::vector<size_t> &capacities, float fillValue = 0.f);	// capacities[nChannels]
+	void resize(size_t capacity);	// Keeps the newest samples, pads the oldest with zeros
+	void resize(const std::vector<size_t> &capacities);
+	void setWindow(size_t window);	// Number of newest samples tracked by getWindowMinMax
+	void setWindow(int channel, size_t window);
+	void setTimestamped(bool timestamped, double interval);	// interval spaces samples pushed without timestamps
+	void setTimestampInterval(int channel, double interval);
+	void setTimeWindow(double seconds);	// Seconds tracked by getWindowMinMax when timestamped
+	bool isTimestamped() const;
+	void setHistory(int channel, std::shared_ptr<ofxScopeHistoryTier> history);	// NULL to detach
+	const ofxScopeHistoryTier * getHistory(int channel) const;
+	void setSampleFormat(int channel, const ofxScopeSampleFormat &format);	// Converts the held samples
+	const ofxScopeSampleFormat & getSampleFormat(int channel) const;
+
+	// Writing
+	void push(int channel, float value);
+	void push(int channel, const float * data, size_t nPoints, size_t stride = 1); // data[nPoints * stride], oldest first
+	void push(int channel, const float * data, const double * timestamps,
+		size_t nPoints, size_t stride = 1);	// timestamps[nPoints] in seconds, oldest first; NaN if unknown
+	void push(int channel, const int16_t * codes, size_t nPoints, size_t stride = 1); // Raw codes, see ofxScopeSampleFormat
+	void pushCode(int channel, int16_t code);
+	bool pushInterleaved(const float * frames, size_t nFrames, int nChannels); // frames[nFrames][nChannels]
+	bool pushFrame(const float * frame, int nChannels);		// One sample per channel, frame[nChannels]
+	bool pushFrame(const int16_t * frame, int nChannels);	// One raw INT16 code per channel
+	void fill(int channel, float value);
+
+	// Reading
+	float at(int channel, size_t age) const;	// age 0 is the newest sample
+	float newest(int channel) const;
+	float atIndex(int channel, uint64_t index) const;	// index is an absolute sample index
+	float codeAtIndex(int channel, uint64_t index) const;	// Stored code; value = code * scale + offset
+	uint64_t getNumWritten(int channel) const;			// Absolute index of the next sample
+	uint64_t getOldestIndex(int channel) const;			// Absolute index of the oldest held sample
+	bool getMinMax(int channel, uint64_t first, uint64_t last,
+		float &min, float &max) const;		// Extremes of absolute indexes [first, last)
+	bool getWindowMinMax(int channel, float &min, float &max) const;	// O(1) extremes of the window
+	double timestampAtIndex(int channel, uint64_t index) const;
+	double getNewestTimestamp(int channel) const;
+	uint64_t findIndex(int channel, double timestamp) const;	// First index with a timestamp >= timestamp
+	const float * channelData(int channel) const;	// Raw ring storage of a FLOAT32 channel
+	void getSegments(int channel, const float * &first, size_t &nFirst,
+		const float * &second, size_t &nSecond) const; // Oldest to newest; FLOAT32 channels only
+
+	int getNumChannels() const;
+	size_t getCapacity(int channel) const;
+
+	void snapshot(ofxScopeSnapshot &snapshot) const;	// Captures the state read by ofxScopeView
+};
+
+/*-------------------------------------------------
+* ofxScopeSampleTraits
+* Maps a sample type to the ofxScopeSampleFormat that
+* stores it unconverted; ofxScopeBuffer::pushFrame
+* takes frames of either type. Specialized for float
+* and int16_t (raw INT16 codes).
+*-------------------------------------------------*/
+template <class SampleT>
+struct ofxScopeSampleTraits;
+
+template <>
+struct ofxScopeSampleTraits<float> {
+	static const ofxScopeSampleFormat::Type type = ofxScopeSampleFormat::FLOAT32;
+};
+
+template <>
+struct ofxScopeSampleTraits<int16_t> {
+	static const ofxScopeSampleFormat::Type type = ofxScopeSampleFormat::INT16;
+};
+
+/*-------------------------------------------------
+* ofxScopeView
+* Read-only view of an ofxScopeBuffer as of an
+* ofxScopeSnapshot. Reads only touch the sample,
+* pyramid and timestamp storage and the snapshot,
+* never state the writer updates, so a render thread
+* can draw from a view while another thread keeps
+* pushing to the buffer.
+*
+* The writer overwrites the oldest samples of the ring
+* as it advances; samples it wrote past the snapshot
+* are not visible. Indexes older than the ring are
+* read from the channel's history tier, if any.
+*
+* Reads are not locked, so a reader that falls behind
+* the writer by a whole ring may read samples while
+* they are overwritten. Readers check afterwards,
+* seqlock style: the writer claims slots before it
+* touches them, and isIntact tells whether anything
+* from a given index on was claimed since the view was
+* taken. Readers then redraw from getIntactOldest or
+* drop what they read.
+*-------------------------------------------------*/
+class ofxScopeView {
+private:
+	const ofxScopeBuffer * _buffer;
+	const ofxScopeSnapshot * _snapshot;
+
+	uint64_t ringOldest(int channel) const;
+
+public:
+	ofxScopeView(const ofxScopeBuffer &buffer, const ofxScopeSnapshot &snapshot);
+
+	int getNumChannels() const;
+	size_t getCapacity(int channel) const;
+	const ofxScopeSampleFormat & getSampleFormat(int channel) const;
+	bool isTimestamped() const;
+	uint64_t getGeneration() const;		// See ofxScopeSnapshot::generation
+
+	float at(int channel, size_t age) const;	// age 0 is the newest sample of the snapshot
+	float atIndex(int channel, uint64_t index) const;
+	float codeAtIndex(int channel, uint64_t index) const;	// Stored code; value = code * scale + offset
+	uint64_t getNumWritten(int channel) const;
+	uint64_t getOldestIndex(int channel) const;
+	bool getMinMax(int channel, uint64_t first, uint64_t last,
+		float &min, float &max) const;		// Extremes of absolute indexes [first, last)
+	bool getWindowMinMax(int channel, float &min, float &max) const;
+	double timestampAtIndex(int channel, uint64_t index) const;
+	double getNewestTimestamp(int channel) const;
+	uint64_t findIndex(int channel, double timestamp) const;	// First index with a timestamp >= timestamp
+
+	// After reading
+	bool isIntact(int channel, uint64_t first) const;	// True if reads from index first on were not overwritten
+	uint64_t getIntactOldest(int channel) const;		// Oldest index not overwritten so far
+};
+
+#endif
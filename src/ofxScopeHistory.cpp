@@ -0,0 +1,643 @@
+//
+//  ofxScopeHistory.cpp
+//
+//  Deep sample history for ofxScopeBuffer beyond what its rings hold
+//
+//  This work is licensed under the Creative Commons
+//  Attribution-ShareAlike 3.0 Unported License.
+//  To view a copy of this license, visit http://creativecommons.org/licenses/by-sa/3.0/.
+//
+#include "ofxScopeHistory.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*-------------------------------------------------
+* ofxScopeMappedHistory
+*-------------------------------------------------*/
+
+ofxScopeMappedHistory::Segment::Segment() {
+	samples = NULL;
+	blocks = NULL;
+	min = 0;
+	max = 0;
+	mapping = NULL;
+	mappingSize = 0;
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	fileMapping = NULL;
+#else
+	file = -1;
+#endif
+}
+
+/*
+** ofxScopeMappedHistory
+** pathPrefix			Directory and file name prefix of the segment files
+** maxSamples			Samples kept before the oldest segment is recycled
+** segmentSize			Samples per segment file (rounded up to whole blocks)
+*/
+ofxScopeMappedHistory::ofxScopeMappedHistory(const std::string &pathPrefix, size_t maxSamples,
+	size_t segmentSize) : _first(0), _end(0) {
+	_pathPrefix = pathPrefix;
+	_nBlocks = std::max((segmentSize + OFX_SCOPE_HISTORY_BLOCK - 1) / OFX_SCOPE_HISTORY_BLOCK, (size_t) 1);
+	_segmentSize = _nBlocks * OFX_SCOPE_HISTORY_BLOCK;
+	// One extra segment so readers keep a whole segment of margin while the oldest is recycled
+	_maxSegments = std::max((maxSamples + _segmentSize - 1) / _segmentSize + 1, (size_t) 2);
+	_segments.reset(new Segment[_maxSegments]);
+	_started = false;
+	_failed = false;
+	_origin = 0;
+}
+
+/*
+** ~ofxScopeMappedHistory
+** Unmaps and removes the segment files.
+*/
+ofxScopeMappedHistory::~ofxScopeMappedHistory() {
+	for (size_t s = 0; s < _maxSegments; s++) {
+		unmap(_segments[s]);
+	}
+}
+
+/*
+** map
+** Creates a segment file of full size and maps it read/write.
+*/
+bool ofxScopeMappedHistory::map(Segment &segment, const std::string &path) {
+	size_t size = (_segmentSize + 2 * _nBlocks) * sizeof(float);
+	segment.path = path;
+#ifdef _WIN32
+	segment.file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL,
+		CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, NULL);
+	if (segment.file == INVALID_HANDLE_VALUE) return false;
+	segment.fileMapping = CreateFileMappingA(segment.file, NULL, PAGE_READWRITE,
+		(DWORD) ((uint64_t) size >> 32), (DWORD) (size & 0xFFFFFFFF), NULL);
+	if (segment.fileMapping == NULL) return false;
+	segment.mapping = MapViewOfFile(segment.fileMapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (segment.mapping == NULL) return false;
+#else
+	segment.file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (segment.file < 0) return false;
+	if (ftruncate(segment.file, size) != 0) return false;
+	void * mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, segment.file, 0);
+	if (mapping == MAP_FAILED) return false;
+	segment.mapping = mapping;
+#endif
+	segment.mappingSize = size;
+	segment.samples = static_cast<float *>(segment.mapping);
+	segment.blocks = segment.samples + _segmentSize;
+	return true;
+}
+
+/*
+** unmap
+** Releases a segment's mapping and removes its file.
+*/
+void ofxScopeMappedHistory::unmap(Segment &segment) {
+#ifdef _WIN32
+	if (segment.mapping != NULL) UnmapViewOfFile(segment.mapping);
+	if (segment.fileMapping != NULL) CloseHandle(segment.fileMapping);
+	if (segment.file != INVALID_HANDLE_VALUE) CloseHandle(segment.file);
+	segment.file = INVALID_HANDLE_VALUE;
+	segment.fileMapping = NULL;
+#else
+	if (segment.mapping != NULL) munmap(segment.mapping, segment.mappingSize);
+	if (segment.file >= 0) close(segment.file);
+	segment.file = -1;
+#endif
+	if (!segment.path.empty()) remove(segment.path.c_str());
+	segment.path.clear();
+	segment.mapping = NULL;
+	segment.samples = NULL;
+	segment.blocks = NULL;
+}
+
+/*
+** segmentFor
+** Returns the segment that stores segmentNumber, mapping its file on first
+** use. Recycling a segment moves the first readable index past it (and a
+** segment of margin) before it is overwritten; the fence keeps the writes to
+** the segment after the move for readers checking getFirstIndex().
+*/
+ofxScopeMappedHistory::Segment * ofxScopeMappedHistory::segmentFor(uint64_t segmentNumber) {
+	Segment &segment = _segments[segmentNumber % _maxSegments];
+	if (segmentNumber >= _maxSegments) {
+		uint64_t first = _origin + (segmentNumber - _maxSegments + 2) * _segmentSize;
+		if (first > _first.load(std::memory_order_relaxed)) {
+			_first.store(first, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+	}
+	if (segment.mapping == NULL) {
+		char number[32];
+		snprintf(number, sizeof(number), "%llu.bin", (unsigned long long) (segmentNumber % _maxSegments));
+		if (!map(segment, _pathPrefix + number)) {
+			fprintf(stderr, "ERROR: ofxScopeMappedHistory could not map %s\n", segment.path.c_str());
+			unmap(segment);
+			return NULL;
+		}
+	}
+	return &segment;
+}
+
+/*
+** segmentOf
+** Returns the segment holding a readable index.
+*/
+const ofxScopeMappedHistory::Segment & ofxScopeMappedHistory::segmentOf(uint64_t index) const {
+	return _segments[((index - _origin) / _segmentSize) % _maxSegments];
+}
+
+/*
+** append
+** Appends nPoints samples whose first sample has absolute index index.
+** Samples already held are skipped; a gap is bridged by repeating data[0].
+** Writer thread only.
+*/
+void ofxScopeMappedHistory::append(uint64_t index, const float * data, size_t nPoints) {
+	if (_failed || nPoints == 0) return;
+	if (!_started) {
+		_origin = index;
+		_first.store(index, std::memory_order_relaxed);
+		_end.store(index, std::memory_order_release);
+		_started = true;
+	}
+	uint64_t end = _end.load(std::memory_order_relaxed);
+	if (index + nPoints <= end) return;
+	if (index < end) {
+		data += end - index;
+		nPoints -= end - index;
+		index = end;
+	}
+	while (index > end && !_failed) {
+		write(data, 1);
+		end++;
+	}
+	write(data, nPoints);
+}
+
+/*
+** write
+** Appends samples at the end of the history, updating the block and segment
+** extremes, and publishes each run to readers once it is complete.
+*/
+void ofxScopeMappedHistory::write(const float * data, size_t nPoints) {
+	uint64_t end = _end.load(std::memory_order_relaxed);
+	while (nPoints > 0) {
+		uint64_t position = end - _origin;
+		size_t offset = (size_t) (position % _segmentSize);
+		Segment * segment = segmentFor(position / _segmentSize);
+		if (segment == NULL) {
+			_failed = true;
+			return;
+		}
+		size_t run = std::min(nPoints, _segmentSize - offset);
+		std::copy(data, data + run, segment->samples + offset);
+		for (size_t j = offset; j < offset + run; j++) {
+			float v = segment->samples[j];
+			float * block = segment->blocks + 2 * (j / OFX_SCOPE_HISTORY_BLOCK);
+			if (j % OFX_SCOPE_HISTORY_BLOCK == 0) {
+				block[0] = v;
+				block[1] = v;
+			} else {
+				block[0] = std::min(block[0], v);
+				block[1] = std::max(block[1], v);
+			}
+			if (j == 0) {
+				segment->min = v;
+				segment->max = v;
+			} else {
+				segment->min = std::min(segment->min, v);
+				segment->max = std::max(segment->max, v);
+			}
+		}
+		data += run;
+		nPoints -= run;
+		end += run;
+		_end.store(end, std::memory_order_release);
+	}
+}
+
+uint64_t ofxScopeMappedHistory::getFirstIndex() const {
+	return _first.load(std::memory_order_acquire);
+}
+
+uint64_t ofxScopeMappedHistory::getEndIndex() const {
+	return _end.load(std::memory_order_acquire);
+}
+
+/*
+** at
+** Returns the sample with a readable absolute index.
+*/
+float ofxScopeMappedHistory::at(uint64_t index) const {
+	return segmentOf(index).samples[(size_t) ((index - _origin) % _segmentSize)];
+}
+
+/*
+** getMinMax
+** Computes the extremes of indexes [first, last), clipped to the readable
+** range. Whole segments use their in-memory extremes, whole blocks the
+** in-file index, and only the partial blocks at either end are scanned.
+** Returns false if the clipped range is empty.
+*/
+bool ofxScopeMappedHistory::getMinMax(uint64_t first, uint64_t last, float &min, float &max) const {
+	first = std::max(first, getFirstIndex());
+	last = std::min(last, getEndIndex());
+	if (first >= last) return false;
+
+	min = at(first);
+	max = min;
+	uint64_t i = first;
+	while (i < last) {
+		const Segment &segment = segmentOf(i);
+		size_t offset = (size_t) ((i - _origin) % _segmentSize);
+		if (offset == 0 && i + _segmentSize <= last) {
+			min = std::min(min, segment.min);
+			max = std::max(max, segment.max);
+			i += _segmentSize;
+		} else if (offset % OFX_SCOPE_HISTORY_BLOCK == 0 && i + OFX_SCOPE_HISTORY_BLOCK <= last) {
+			const float * block = segment.blocks + 2 * (offset / OFX_SCOPE_HISTORY_BLOCK);
+			min = std::min(min, block[0]);
+			max = std::max(max, block[1]);
+			i += OFX_SCOPE_HISTORY_BLOCK;
+		} else {
+			float v = segment.samples[offset];
+			min = std::min(min, v);
+			max = std::max(max, v);
+			i++;
+		}
+	}
+	return true;
+}
+
+/*-------------------------------------------------
+* ofxScopeCompressedHistory
+*-------------------------------------------------*/
+
+/*
+** writeBits
+** Appends the count low bits of value to a bit stream of nBits bits.
+*/
+static void writeBits(std::vector<uint64_t> &words, size_t &nBits, uint64_t value, int count) {
+	if (count == 0) return;
+	size_t word = nBits / 64;
+	int shift = nBits % 64;
+	if (word >= words.size()) words.push_back(0);
+	words[word] |= value << shift;
+	if (shift + count > 64) {
+		words.push_back(value >> (64 - shift));
+	}
+	nBits += count;
+}
+
+/*
+** readBits
+** Reads count (at most 32) bits at position and advances it.
+*/
+static uint32_t readBits(const uint64_t * words, size_t &position, int count) {
+	if (count == 0) return 0;
+	size_t word = position / 64;
+	int shift = position % 64;
+	uint64_t value = words[word] >> shift;
+	if (shift + count > 64) {
+		value |= words[word + 1] << (64 - shift);
+	}
+	position += count;
+	return (uint32_t) (value & ((((uint64_t) 1) << count) - 1));
+}
+
+static inline int leadingZeros(uint32_t x) {	// x != 0
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_clz(x);
+#else
+	int n = 0;
+	while (!(x & 0x80000000u)) { x <<= 1; n++; }
+	return n;
+#endif
+}
+
+static inline int trailingZeros(uint32_t x) {	// x != 0
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctz(x);
+#else
+	int n = 0;
+	while (!(x & 1u)) { x >>= 1; n++; }
+	return n;
+#endif
+}
+
+/*
+** ofxScopeDecodeCache
+** Samples of the sealed block a reader thread decoded last. Sealed blocks
+** never change, so a history's ID and a block number identify the samples.
+*/
+struct ofxScopeDecodeCache {
+	uint64_t history;	// ID of the history; 0 when empty
+	uint64_t block;
+	std::vector<float> samples;
+};
+
+static thread_local ofxScopeDecodeCache decodeCache = { 0, 0, std::vector<float>() };
+static std::atomic<uint64_t> nextHistoryId(1);
+
+/*
+** ofxScopeCompressedHistory
+** maxSamples			Samples kept before the oldest block is recycled
+** blockSize			Samples per compressed block
+*/
+ofxScopeCompressedHistory::ofxScopeCompressedHistory(size_t maxSamples, size_t blockSize) :
+	_first(0), _end(0), _claimed(0) {
+	_id = nextHistoryId.fetch_add(1, std::memory_order_relaxed);
+	_blockSize = std::max(blockSize, (size_t) 2);
+	// One extra block so readers keep a whole block of margin while the oldest is recycled
+	_maxBlocks = std::max((maxSamples + _blockSize - 1) / _blockSize + 1, (size_t) 2);
+	_blocks.reset(new std::shared_ptr<const Block>[_maxBlocks]);
+	_raw[0].assign(_blockSize, 0.f);
+	_raw[1].assign(_blockSize, 0.f);
+	_started = false;
+	_origin = 0;
+}
+
+/*
+** append
+** Appends nPoints samples whose first sample has absolute index index.
+** Samples already held are skipped; a gap is bridged by repeating data[0].
+** Writer thread only.
+*/
+void ofxScopeCompressedHistory::append(uint64_t index, const float * data, size_t nPoints) {
+	if (nPoints == 0) return;
+	if (!_started) {
+		_origin = index;
+		_first.store(index, std::memory_order_relaxed);
+		_claimed.store(index, std::memory_order_relaxed);
+		_end.store(index, std::memory_order_release);
+		_started = true;
+	}
+	uint64_t end = _end.load(std::memory_order_relaxed);
+	if (index + nPoints <= end) return;
+	if (index < end) {
+		data += end - index;
+		nPoints -= end - index;
+		index = end;
+	}
+	while (index > end) {
+		write(data, 1);
+		end++;
+	}
+	write(data, nPoints);
+}
+
+/*
+** write
+** Appends samples to the raw block at the end of the history, sealing it
+** once full, and publishes each run to readers. Each run is claimed before
+** it is copied, as it may reuse the raw block of two blocks back.
+*/
+void ofxScopeCompressedHistory::write(const float * data, size_t nPoints) {
+	uint64_t end = _end.load(std::memory_order_relaxed);
+	while (nPoints > 0) {
+		uint64_t position = end - _origin;
+		uint64_t blockNumber = position / _blockSize;
+		size_t offset = (size_t) (position % _blockSize);
+		size_t run = std::min(nPoints, _blockSize - offset);
+		_claimed.store(end + run, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		std::copy(data, data + run, _raw[blockNumber % 2].begin() + offset);
+		if (offset + run == _blockSize) {
+			seal(blockNumber);
+		}
+		data += run;
+		nPoints -= run;
+		end += run;
+		_end.store(end, std::memory_order_release);
+	}
+}
+
+/*
+** seal
+** Encodes a full raw block into a new sealed block and swaps it into its
+** slot of the block ring; the block it replaces is freed once no reader
+** holds it. The first sample is stored whole; each following sample is
+** XORed with the previous one and stored as a single 0 bit if equal,
+** otherwise as the meaningful (non zero) bits of the XOR, reusing the
+** previous leading/trailing zero counts when they still fit.
+*/
+void ofxScopeCompressedHistory::seal(uint64_t blockNumber) {
+	if (blockNumber >= _maxBlocks) {
+		// Move readers off the slot (and a block of margin) before reusing it
+		uint64_t first = _origin + (blockNumber - _maxBlocks + 2) * _blockSize;
+		if (first > _first.load(std::memory_order_relaxed)) {
+			_first.store(first, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+	}
+
+	const std::vector<float> &raw = _raw[blockNumber % 2];
+	std::shared_ptr<Block> block(new Block());
+	std::vector<uint64_t> &encoded = block->bits;
+	size_t nBits = 0;
+	uint32_t previous;
+	memcpy(&previous, &raw[0], sizeof(previous));
+	writeBits(encoded, nBits, previous, 32);
+	int leading = -1;	// No meaningful bit window yet
+	int trailing = 0;
+	float min = raw[0];
+	float max = raw[0];
+	for (size_t j = 1; j < _blockSize; j++) {
+		min = std::min(min, raw[j]);
+		max = std::max(max, raw[j]);
+		uint32_t value;
+		memcpy(&value, &raw[j], sizeof(value));
+		uint32_t x = value ^ previous;
+		previous = value;
+		if (x == 0) {
+			writeBits(encoded, nBits, 0, 1);
+			continue;
+		}
+		writeBits(encoded, nBits, 1, 1);
+		int lz = std::min(leadingZeros(x), 31);
+		int tz = trailingZeros(x);
+		if (leading >= 0 && lz >= leading && tz >= trailing) {
+			writeBits(encoded, nBits, 0, 1);
+			writeBits(encoded, nBits, x >> trailing, 32 - leading - trailing);
+		} else {
+			int length = 32 - lz - tz;
+			writeBits(encoded, nBits, 1, 1);
+			writeBits(encoded, nBits, lz, 5);
+			writeBits(encoded, nBits, length - 1, 5);
+			writeBits(encoded, nBits, x >> tz, length);
+			leading = lz;
+			trailing = tz;
+		}
+	}
+	encoded.shrink_to_fit();
+	block->number = blockNumber;
+	block->min = min;
+	block->max = max;
+	std::atomic_store(&_blocks[blockNumber % _maxBlocks], std::shared_ptr<const Block>(block));
+}
+
+/*
+** sealed
+** Returns sealed block blockNumber, or NULL if its slot holds another block:
+** one not sealed yet, or one recycled since.
+*/
+std::shared_ptr<const ofxScopeCompressedHistory::Block> ofxScopeCompressedHistory::sealed(uint64_t blockNumber) const {
+	std::shared_ptr<const Block> block = std::atomic_load(&_blocks[blockNumber % _maxBlocks]);
+	if (block && block->number != blockNumber) {
+		block.reset();
+	}
+	return block;
+}
+
+/*
+** isRawIntact
+** Call after reading the raw copy of a block: returns true if the writer has
+** not claimed it for the block two further since, seqlock style.
+*/
+bool ofxScopeCompressedHistory::isRawIntact(uint64_t blockNumber) const {
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return _claimed.load(std::memory_order_relaxed) <= _origin + (blockNumber + 2) * _blockSize;
+}
+
+/*
+** decoded
+** Returns the samples of a sealed block, decoded into the calling thread's
+** cache, or NULL if the block was recycled.
+*/
+const float * ofxScopeCompressedHistory::decoded(uint64_t blockNumber) const {
+	ofxScopeDecodeCache &cache = decodeCache;
+	if (cache.history == _id && cache.block == blockNumber) {
+		return cache.samples.data();
+	}
+	std::shared_ptr<const Block> block = sealed(blockNumber);
+	if (!block) return NULL;
+
+	cache.samples.resize(_blockSize);
+	const uint64_t * words = block->bits.data();
+	size_t position = 0;
+	uint32_t value = readBits(words, position, 32);
+	memcpy(&cache.samples[0], &value, sizeof(value));
+	int leading = 0;
+	int trailing = 0;
+	for (size_t j = 1; j < _blockSize; j++) {
+		if (readBits(words, position, 1) != 0) {
+			if (readBits(words, position, 1) != 0) {
+				leading = readBits(words, position, 5);
+				int length = readBits(words, position, 5) + 1;
+				trailing = 32 - leading - length;
+			}
+			value ^= readBits(words, position, 32 - leading - trailing) << trailing;
+		}
+		memcpy(&cache.samples[j], &value, sizeof(value));
+	}
+	cache.history = _id;
+	cache.block = blockNumber;
+	return cache.samples.data();
+}
+
+uint64_t ofxScopeCompressedHistory::getFirstIndex() const {
+	return _first.load(std::memory_order_acquire);
+}
+
+uint64_t ofxScopeCompressedHistory::getEndIndex() const {
+	return _end.load(std::memory_order_acquire);
+}
+
+/*
+** at
+** Returns the sample with a readable absolute index. Sequential reads
+** decode each sealed block once. A sample recycled meanwhile reads as 0;
+** see ofxScopeHistoryTier for how readers tell.
+*/
+float ofxScopeCompressedHistory::at(uint64_t index) const {
+	uint64_t position = index - _origin;
+	uint64_t blockNumber = position / _blockSize;
+	size_t offset = (size_t) (position % _blockSize);
+	if (_origin + (blockNumber + 1) * _blockSize > getEndIndex()) {
+		// Not sealed yet
+		float v = _raw[blockNumber % 2][offset];
+		if (isRawIntact(blockNumber)) return v;
+	}
+	const float * samples = decoded(blockNumber);
+	return samples != NULL ? samples[offset] : 0.f;
+}
+
+/*
+** getMinMax
+** Computes the extremes of indexes [first, last), clipped to the readable
+** range. Whole sealed blocks use their stored extremes; only partial
+** blocks at either end and the raw newest block are scanned.
+** Returns false if the clipped range is empty.
+*/
+bool ofxScopeCompressedHistory::getMinMax(uint64_t first, uint64_t last, float &min, float &max) const {
+	uint64_t end = getEndIndex();
+	first = std::max(first, getFirstIndex());
+	last = std::min(last, end);
+	if (first >= last) return false;
+
+	uint64_t openBlock = (end - _origin) / _blockSize;
+	bool found = false;
+	uint64_t i = first;
+	while (i < last) {
+		uint64_t position = i - _origin;
+		uint64_t blockNumber = position / _blockSize;
+		size_t offset = (size_t) (position % _blockSize);
+		size_t run = (size_t) std::min((uint64_t) (_blockSize - offset), last - i);
+		i += run;
+
+		float runMin, runMax;
+		if (blockNumber >= openBlock) {
+			const float * samples = _raw[blockNumber % 2].data() + offset;
+			runMin = *std::min_element(samples, samples + run);
+			runMax = *std::max_element(samples, samples + run);
+			if (!isRawIntact(blockNumber)) {
+				// Sealed and reused meanwhile
+				const float * decodedSamples = decoded(blockNumber);
+				if (decodedSamples == NULL) continue;
+				runMin = *std::min_element(decodedSamples + offset, decodedSamples + offset + run);
+				runMax = *std::max_element(decodedSamples + offset, decodedSamples + offset + run);
+			}
+		} else if (offset == 0 && run == _blockSize) {
+			std::shared_ptr<const Block> block = sealed(blockNumber);
+			if (!block) continue;
+			runMin = block->min;
+			runMax = block->max;
+		} else {
+			const float * samples = decoded(blockNumber);
+			if (samples == NULL) continue;
+			runMin = *std::min_element(samples + offset, samples + offset + run);
+			runMax = *std::max_element(samples + offset, samples + offset + run);
+		}
+		min = found ? std::min(min, runMin) : runMin;
+		max = found ? std::max(max, runMax) : runMax;
+		found = true;
+	}
+	return found;
+}
+
+/*
+** getCompressedBytes
+** Returns the memory taken by the encoded samples of the sealed blocks.
+*/
+size_t ofxScopeCompressedHistory::getCompressedBytes() const {
+	size_t bytes = 0;
+	for (size_t b = 0; b < _maxBlocks; b++) {
+		std::shared_ptr<const Block> block = std::atomic_load(&_blocks[b]);
+		if (block) {
+			bytes += block->bits.size() * sizeof(uint64_t);
+		}
+	}
+	return bytes;
+}
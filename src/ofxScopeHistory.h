@@ -0,0 +1,188 @@
+//
+//  ofxScopeHistory.h
+//
+//  Deep sample history for ofxScopeBuffer beyond what its rings hold
+//
+//  This work is licensed under the Creative Commons
+//  Attribution-ShareAlike 3.0 Unported License.
+//  To view a copy of this license, visit http://creativecommons.org/licenses/by-sa/3.0/.
+//
+
+#ifndef _OFX_SCOPE_HISTORY
+#define _OFX_SCOPE_HISTORY
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/*-------------------------------------------------
+* ofxScopeHistoryTier
+* Storage for samples evicted from one ofxScopeBuffer
+* channel, addressed by the same absolute sample
+* indexes. The buffer's writer appends; a render
+* thread may read concurrently, but only indexes in
+* [getFirstIndex(), getEndIndex()).
+*
+* Storage is recycled only after getFirstIndex() has
+* moved past it, with a release fence in between, so a
+* reader that still finds getFirstIndex() at or below
+* the indexes it read, after an acquire fence, read
+* them intact (see ofxScopeView::isIntact).
+*-------------------------------------------------*/
+class ofxScopeHistoryTier {
+public:
+	virtual ~ofxScopeHistoryTier() {}
+
+	// Writer
+	virtual void append(uint64_t index, const float * data, size_t nPoints) = 0; // index of data[0], oldest first
+
+	// Readers
+	virtual uint64_t getFirstIndex() const = 0;	// Oldest readable index
+	virtual uint64_t getEndIndex() const = 0;	// Index after the newest appended sample
+	virtual float at(uint64_t index) const = 0;
+	virtual bool getMinMax(uint64_t first, uint64_t last,
+		float &min, float &max) const = 0;		// Extremes of indexes [first, last)
+};
+
+/*-------------------------------------------------
+* ofxScopeMappedHistory
+* History tier that spills samples into append-only
+* memory-mapped segment files. Each segment holds
+* segmentSize samples followed by a min/max index of
+* blocks of OFX_SCOPE_HISTORY_BLOCK samples, and keeps
+* its overall min/max in memory, so range extremes read
+* only whole segment extremes, block extremes and at
+* most two partial blocks of raw samples.
+*
+* At most maxSegments segment files are used; after
+* that the oldest segment is recycled. The operating
+* system pages the mappings in and out, so resident
+* memory stays bounded however long the history.
+* Segment files are removed when the history is
+* destroyed.
+*-------------------------------------------------*/
+#define OFX_SCOPE_HISTORY_BLOCK 1024	// Samples per block of the in-file min/max index
+
+class ofxScopeMappedHistory : public ofxScopeHistoryTier {
+private:
+	struct Segment {
+		float * samples;		// [segmentSize]
+		float * blocks;			// [nBlocks][min, max]
+		float min;				// Extremes of the whole segment once full
+		float max;
+		void * mapping;
+		size_t mappingSize;
+#ifdef _WIN32
+		void * file;
+		void * fileMapping;
+#else
+		int file;
+#endif
+		std::string path;
+
+		Segment();
+	};
+
+	std::string _pathPrefix;
+	size_t _segmentSize;
+	size_t _nBlocks;			// Blocks per segment
+	size_t _maxSegments;
+	std::unique_ptr<Segment[]> _segments;	// Ring of maxSegments
+	bool _started;
+	bool _failed;
+	uint64_t _origin;			// Index of the first sample of segment 0
+	std::atomic<uint64_t> _first;
+	std::atomic<uint64_t> _end;
+
+	Segment * segmentFor(uint64_t segmentNumber);
+	const Segment & segmentOf(uint64_t index) const;
+	bool map(Segment &segment, const std::string &path);
+	void unmap(Segment &segment);
+	void write(const float * data, size_t nPoints);
+
+	// Not copyable: segment files have one owner
+	ofxScopeMappedHistory(const ofxScopeMappedHistory &other);
+	ofxScopeMappedHistory& operator=(const ofxScopeMappedHistory &other);
+
+public:
+	ofxScopeMappedHistory(const std::string &pathPrefix, size_t maxSamples,
+		size_t segmentSize = 1 << 20);	// Files are named pathPrefix + segment number
+	~ofxScopeMappedHistory();
+
+	void append(uint64_t index, const float * data, size_t nPoints);
+
+	uint64_t getFirstIndex() const;
+	uint64_t getEndIndex() const;
+	float at(uint64_t index) const;
+	bool getMinMax(uint64_t first, uint64_t last, float &min, float &max) const;
+};
+
+/*-------------------------------------------------
+* ofxScopeCompressedHistory
+* History tier that keeps samples in memory,
+* compressed. Every full block of blockSize samples is
+* sealed with Gorilla-style XOR encoding: a sample
+* equal to the previous one takes one bit, and one
+* that differs in few bits takes little more. Slowly
+* changing or quantized signals shrink several times.
+*
+* The newest block stays raw until it is full. Each
+* sealed block keeps its min/max, so range extremes
+* over whole blocks (e.g. one pixel column of a zoomed
+* out plot) never decompress; partial blocks are
+* decoded into a one block cache per reader thread.
+*
+* At most maxSamples are kept; the oldest blocks are
+* then recycled. Sealed blocks are immutable and are
+* swapped into their slot whole, so a reader holding
+* one keeps it alive however far the writer gets, and
+* checks its block number before using it. Reads of
+* the raw block are checked against the writer's claim
+* on it, seqlock style. Any number of threads may read.
+*-------------------------------------------------*/
+class ofxScopeCompressedHistory : public ofxScopeHistoryTier {
+private:
+	struct Block {
+		uint64_t number;			// Block number, telling a recycled slot apart
+		std::vector<uint64_t> bits;	// Encoded samples, least significant bit first
+		float min;
+		float max;
+	};
+
+	uint64_t _id;					// Unique per history; keys the readers' decode caches
+	size_t _blockSize;
+	size_t _maxBlocks;
+	std::unique_ptr<std::shared_ptr<const Block>[]> _blocks;	// Ring of maxBlocks sealed blocks; atomic_load/atomic_store only
+	std::vector<float> _raw[2];		// Newest two blocks, alternating by block number
+	bool _started;
+	uint64_t _origin;				// Index of the first sample of block 0
+	std::atomic<uint64_t> _first;
+	std::atomic<uint64_t> _end;
+	std::atomic<uint64_t> _claimed;	// Index after the newest sample being written to a raw block
+
+	void write(const float * data, size_t nPoints);
+	void seal(uint64_t blockNumber);
+	std::shared_ptr<const Block> sealed(uint64_t blockNumber) const;
+	bool isRawIntact(uint64_t blockNumber) const;
+	const float * decoded(uint64_t blockNumber) const;
+
+	// Not copyable: readers hold on to the blocks
+	ofxScopeCompressedHistory(const ofxScopeCompressedHistory &other);
+	ofxScopeCompressedHistory& operator=(const ofxScopeCompressedHistory &other);
+
+public:
+	ofxScopeCompressedHistory(size_t maxSamples, size_t blockSize = OFX_SCOPE_HISTORY_BLOCK);
+
+	void append(uint64_t index, const float * data, size_t nPoints);
+
+	uint64_t getFirstIndex() const;
+	uint64_t getEndIndex() const;
+	float at(uint64_t index) const;
+	bool getMinMax(uint64_t first, uint64_t last, float &min, float &max) const;
+	size_t getCompressedBytes() const;	// Memory taken by the sealed blocks
+};
+
+#endif
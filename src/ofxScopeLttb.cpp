@@ -0,0 +1,132 @@
+//
+//  ofxScopeLttb.cpp
+//
+//  Largest-Triangle-Three-Buckets downsampling of one ofxScopeBuffer channel
+//
+//  This work is licensed under the Creative Commons
+//  Attribution-ShareAlike 3.0 Unported License.
+//  To view a copy of this license, visit http://creativecommons.org/licenses/by-sa/3.0/.
+//
+#include "ofxScopeLttb.h"
+#include <algorithm>
+#include <cmath>
+
+/*
+** ofxScopeLttb
+*/
+ofxScopeLttb::ofxScopeLttb() {
+	_bucketSize = 0;
+	_firstBucket = 0;
+}
+
+/*
+** select
+** Returns about nPoints samples of [first, last) to draw, oldest first: the
+** first and newest samples plus one per bucket. Ranges of at most nPoints
+** samples are returned whole. Choices of complete buckets are kept between
+** calls; a bucket is computed once when it scrolls in, and again only if the
+** bucket size changes (nPoints or the length of the range changed) or the
+** range jumps away from the kept buckets.
+*/
+const std::vector<ofxScopeLttb::Point> & ofxScopeLttb::select(const ofxScopeView &view, int channel,
+	uint64_t first, uint64_t last, size_t nPoints) {
+	_points.clear();
+	if (first >= last) return _points;
+
+	uint64_t nSamples = last - first;
+	if (nPoints < 3 || nSamples <= nPoints) {
+		for (uint64_t n = first; n < last; n++) {
+			Point point = { n, view.codeAtIndex(channel, n) };
+			_points.push_back(point);
+		}
+		return _points;
+	}
+
+	// The first and newest samples stand alone; nPoints - 2 buckets share the rest
+	uint64_t bucketSize = (nSamples + nPoints - 3) / (nPoints - 2);
+	if (bucketSize != _bucketSize) {
+		invalidate();
+		_bucketSize = bucketSize;
+	}
+	uint64_t firstBucket = first / _bucketSize;
+	uint64_t lastBucket = (last - 1) / _bucketSize;	// Bucket of the newest sample
+
+	// Drop choices that scrolled out; start over if the range left the kept buckets
+	if (!_kept.empty() && (firstBucket < _firstBucket || firstBucket >= _firstBucket + _kept.size())) {
+		_kept.clear();
+	}
+	while (!_kept.empty() && _firstBucket < firstBucket) {
+		_kept.pop_front();
+		_firstBucket++;
+	}
+	if (_kept.empty()) {
+		// A new chain starts from the first sample of the range
+		Point start = { first, view.codeAtIndex(channel, first) };
+		_firstBucket = firstBucket;
+		_kept.push_back(start);
+	}
+
+	// Keep the choice of every bucket whose next bucket is complete
+	uint64_t bucket = _firstBucket + _kept.size();
+	while ((bucket + 2) * _bucketSize <= last) {
+		_kept.push_back(choose(view, channel, _kept.back(), bucket, last));
+		bucket++;
+	}
+
+	Point start = { first, view.codeAtIndex(channel, first) };
+	_points.push_back(start);
+	for (size_t k = 0; k < _kept.size() && _firstBucket + k < lastBucket; k++) {
+		if (_kept[k].index > first) {
+			_points.push_back(_kept[k]);
+		}
+	}
+	// Buckets next to the newest sample change every update; choose them afresh
+	Point previous = _kept.back();
+	for (; bucket < lastBucket; bucket++) {
+		previous = choose(view, channel, previous, bucket, last);
+		_points.push_back(previous);
+	}
+	if (last - 1 > first) {
+		Point end = { last - 1, view.codeAtIndex(channel, last - 1) };
+		_points.push_back(end);
+	}
+	return _points;
+}
+
+/*
+** choose
+** Returns the sample of bucket forming the largest triangle with previous and
+** the mean of the next bucket, clipped to last. The next bucket must hold at
+** least one sample before last.
+*/
+ofxScopeLttb::Point ofxScopeLttb::choose(const ofxScopeView &view, int channel, const Point &previous,
+	uint64_t bucket, uint64_t last) const {
+	uint64_t nextFirst = (bucket + 1) * _bucketSize;
+	uint64_t nextLast = std::min(nextFirst + _bucketSize, last);
+	double meanCode = 0;
+	for (uint64_t n = nextFirst; n < nextLast; n++) {
+		meanCode += view.codeAtIndex(channel, n);
+	}
+	meanCode /= (double) (nextLast - nextFirst);
+	// x is measured from previous so large absolute indexes keep their precision
+	double meanX = (double) (nextFirst - previous.index) + (nextLast - 1 - nextFirst) / 2.;
+
+	Point best = { bucket * _bucketSize, 0.f };
+	double bestArea = -1;
+	for (uint64_t n = bucket * _bucketSize; n < nextFirst; n++) {
+		float code = view.codeAtIndex(channel, n);
+		double x = (double) (n - previous.index);
+		double area = fabs(x * (meanCode - previous.code) - meanX * (code - previous.code));
+		if (area > bestArea) {
+			bestArea = area;
+			best.index = n;
+			best.code = code;
+		}
+	}
+	return best;
+}
+
+void ofxScopeLttb::invalidate() {
+	_bucketSize = 0;
+	_kept.clear();
+}
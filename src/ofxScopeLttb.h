@@ -0,0 +1,62 @@
+//
+//  ofxScopeLttb.h
+//
+//  Largest-Triangle-Three-Buckets downsampling of one ofxScopeBuffer channel
+//
+//  This work is licensed under the Creative Commons
+//  Attribution-ShareAlike 3.0 Unported License.
+//  To view a copy of this license, visit http://creativecommons.org/licenses/by-sa/3.0/.
+//
+
+#ifndef _OFX_SCOPE_LTTB
+#define _OFX_SCOPE_LTTB
+
+#include <vector>
+#include <deque>
+#include <cstddef>
+#include <cstdint>
+
+#include "ofxScopeBuffer.h"
+
+/*-------------------------------------------------
+* ofxScopeLttb
+* Reduces a range of samples of one channel to about
+* nPoints samples that keep its visual shape, using
+* Largest-Triangle-Three-Buckets: each bucket keeps the
+* sample forming the largest triangle with the sample
+* kept from the previous bucket and the mean of the
+* next one. Smooth signals stay smooth, unlike a min/max
+* envelope.
+*
+* Buckets are aligned to absolute sample indexes and the
+* choice made for a bucket is kept once the bucket after
+* it is complete, so as the range scrolls only buckets
+* that scrolled in are computed and kept samples never
+* jump. Codes are compared, not values: the y transform
+* of a sample format does not change which sample wins.
+*-------------------------------------------------*/
+class ofxScopeLttb {
+public:
+	struct Point {
+		uint64_t index;
+		float code;
+	};
+
+private:
+	uint64_t _bucketSize;		// Samples per bucket; 0 when nothing is kept
+	uint64_t _firstBucket;		// Bucket of _kept.front()
+	std::deque<Point> _kept;	// Choice of each bucket from _firstBucket on
+	std::vector<Point> _points;	// Result of the last select
+
+	Point choose(const ofxScopeView &view, int channel, const Point &previous,
+		uint64_t bucket, uint64_t last) const;
+
+public:
+	ofxScopeLttb();
+
+	const std::vector<Point> & select(const ofxScopeView &view, int channel,
+		uint64_t first, uint64_t last, size_t nPoints);	// Samples to draw from [first, last), oldest first
+	void invalidate();		// Forgets every kept choice
+};
+
+#endif
@@ -0,0 +1,320 @@
+//
+//  ofxScopeQueue.cpp
+//
+//  Lock-free ingest queues feeding ofxScopePlot from acquisition threads
+//
+//  This work is licensed under the Creative Commons
+//  Attribution-ShareAlike 3.0 Unported License.
+//  To view a copy of this license, visit http://creativecommons.org/licenses/by-sa/3.0/.
+//
+#include "ofxScopeQueue.h"
+#include <algorithm>
+#include <limits>
+
+/*-------------------------------------------------
+* ofxScopeSpscQueue
+*-------------------------------------------------*/
+
+/*
+** ofxScopeSpscQueue
+*/
+ofxScopeSpscQueue::ofxScopeSpscQueue() : _tail(0), _head(0), _overruns(0) {
+	_capacity = 0;
+	_frameSize = 0;
+}
+
+ofxScopeSpscQueue::ofxScopeSpscQueue(const ofxScopeSpscQueue &other) : _tail(0), _head(0), _overruns(0) {
+	_capacity = 0;
+	_frameSize = 0;
+	setup(other._capacity, other._frameSize);
+}
+
+ofxScopeSpscQueue& ofxScopeSpscQueue::operator=(const ofxScopeSpscQueue &other) {
+	if (this != &other) {
+		setup(other._capacity, other._frameSize);
+	}
+	return *this;
+}
+
+/*
+** setup
+** Allocates room for capacity frames of frameSize floats and empties the queue.
+** Must not be called while a producer or consumer is active.
+*/
+void ofxScopeSpscQueue::setup(size_t capacity, int frameSize) {
+	_capacity = 0;
+	if (capacity > 0) {
+		_capacity = 1;
+		while (_capacity < capacity) {
+			_capacity <<= 1;
+		}
+	}
+	_frameSize = std::max(frameSize, 0);
+	_frames.assign(_capacity * _frameSize, 0.f);
+	_timestamps.assign(_capacity, std::numeric_limits<double>::quiet_NaN());
+	_tail.store(0, std::memory_order_relaxed);
+	_head.store(0, std::memory_order_relaxed);
+	_overruns.store(0, std::memory_order_relaxed);
+}
+
+/*
+** push
+** Queues one frame. Returns false and counts an overrun if the queue is full.
+** Producer thread only.
+*/
+bool ofxScopeSpscQueue::push(const float * frame) {
+	return push(frame, NULL, 1) == 1;
+}
+
+bool ofxScopeSpscQueue::push(const float * frame, double timestamp) {
+	return push(frame, &timestamp, 1) == 1;
+}
+
+/*
+** push
+** Queues as many of nFrames frames (oldest first) as fit and counts the rest
+** as overruns. Returns the number of frames queued. Producer thread only.
+*/
+size_t ofxScopeSpscQueue::push(const float * frames, const double * timestamps, size_t nFrames) {
+	uint64_t tail = _tail.load(std::memory_order_relaxed);
+	uint64_t head = _head.load(std::memory_order_acquire);
+	size_t nFree = _capacity - (size_t) (tail - head);
+	size_t nPush = std::min(nFrames, nFree);
+	if (nPush < nFrames) {
+		_overruns.fetch_add(nFrames - nPush, std::memory_order_relaxed);
+	}
+
+	for (size_t f = 0; f < nPush; f++) {
+		size_t slot = (size_t) (tail + f) & (_capacity - 1);
+		std::copy(frames + f * _frameSize, frames + (f + 1) * _frameSize, &_frames[slot * _frameSize]);
+		_timestamps[slot] = (timestamps != NULL) ? timestamps[f] : std::numeric_limits<double>::quiet_NaN();
+	}
+	// Publish the frames to the consumer
+	_tail.store(tail + nPush, std::memory_order_release);
+	return nPush;
+}
+
+/*
+** peek
+** Returns the number of frames in the oldest contiguous run of queued frames
+** and points frames/timestamps at it. Call again after pop() to read a run
+** that wrapped around the end of the storage. Consumer thread only.
+*/
+size_t ofxScopeSpscQueue::peek(const float * &frames, const double * &timestamps) {
+	uint64_t head = _head.load(std::memory_order_relaxed);
+	uint64_t tail = _tail.load(std::memory_order_acquire);
+	if (tail == head) return 0;
+	size_t slot = (size_t) head & (_capacity - 1);
+	size_t nFrames = std::min((size_t) (tail - head), _capacity - slot);
+	frames = &_frames[slot * _frameSize];
+	timestamps = &_timestamps[slot];
+	return nFrames;
+}
+
+/*
+** pop
+** Releases the oldest nFrames frames back to the producer. Consumer thread only.
+*/
+void ofxScopeSpscQueue::pop(size_t nFrames) {
+	_head.store(_head.load(std::memory_order_relaxed) + nFrames, std::memory_order_release);
+}
+
+/*
+** size
+** Returns the number of frames currently queued. Exact only on the consumer thread.
+*/
+size_t ofxScopeSpscQueue::size() const {
+	uint64_t head = _head.load(std::memory_order_acquire);
+	uint64_t tail = _tail.load(std::memory_order_acquire);
+	return (size_t) (tail - head);
+}
+
+size_t ofxScopeSpscQueue::getCapacity() const {
+	return _capacity;
+}
+
+int ofxScopeSpscQueue::getFrameSize() const {
+	return _frameSize;
+}
+
+/*
+** getOverruns
+** Returns the number of frames dropped because the queue was full.
+*/
+uint64_t ofxScopeSpscQueue::getOverruns() const {
+	return _overruns.load(std::memory_order_relaxed);
+}
+
+uint64_t ofxScopeSpscQueue::resetOverruns() {
+	return _overruns.exchange(0, std::memory_order_relaxed);
+}
+
+/*-------------------------------------------------
+* ofxScopeMpscQueue
+*-------------------------------------------------*/
+
+/*
+** ofxScopeMpscQueue
+*/
+ofxScopeMpscQueue::ofxScopeMpscQueue() : _tail(0), _nProducers(0) {
+	_capacity = 0;
+	_maxProducers = 0;
+	_head = 0;
+}
+
+ofxScopeMpscQueue::ofxScopeMpscQueue(const ofxScopeMpscQueue &other) : _tail(0), _nProducers(0) {
+	_capacity = 0;
+	_maxProducers = 0;
+	_head = 0;
+	setup(other._capacity, other._maxProducers);
+}
+
+ofxScopeMpscQueue& ofxScopeMpscQueue::operator=(const ofxScopeMpscQueue &other) {
+	if (this != &other) {
+		setup(other._capacity, other._maxProducers);
+	}
+	return *this;
+}
+
+/*
+** setup
+** Allocates room for capacity samples and maxProducers producers, and empties
+** the queue. Must not be called while producers or the consumer are active.
+*/
+void ofxScopeMpscQueue::setup(size_t capacity, int maxProducers) {
+	_capacity = 0;
+	if (capacity > 0) {
+		_capacity = 1;
+		while (_capacity < capacity) {
+			_capacity <<= 1;
+		}
+	}
+	_slots.reset(_capacity > 0 ? new Slot[_capacity] : NULL);
+	for (size_t i = 0; i < _capacity; i++) {
+		_slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	_maxProducers = std::max(maxProducers, 0);
+	_producers.reset(_maxProducers > 0 ? new ProducerCounters[_maxProducers] : NULL);
+	for (int i = 0; i < _maxProducers; i++) {
+		_producers[i].pushed.store(0, std::memory_order_relaxed);
+		_producers[i].overflows.store(0, std::memory_order_relaxed);
+		_producers[i].drops.store(0, std::memory_order_relaxed);
+	}
+	_nProducers.store(0, std::memory_order_relaxed);
+	_tail.store(0, std::memory_order_relaxed);
+	_head = 0;
+}
+
+/*
+** addProducer
+** Registers a producer and returns its ID for push(). Thread safe.
+** Returns -1 if maxProducers producers are already registered.
+*/
+int ofxScopeMpscQueue::addProducer() {
+	int producer = _nProducers.fetch_add(1, std::memory_order_relaxed);
+	if (producer >= _maxProducers) {
+		_nProducers.fetch_sub(1, std::memory_order_relaxed);
+		return -1;
+	}
+	return producer;
+}
+
+/*
+** push
+** Queues one sample from any thread. Returns false and counts an overflow
+** for the producer if the queue is full.
+*/
+bool ofxScopeMpscQueue::push(int producer, const ofxScopeSample &sample) {
+	if (producer < 0 || producer >= _maxProducers) return false;
+	ProducerCounters &counters = _producers[producer];
+
+	uint64_t pos = _tail.load(std::memory_order_relaxed);
+	Slot * slot;
+	while (true) {
+		if (_capacity == 0) {
+			counters.overflows.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		slot = &_slots[(size_t) pos & (_capacity - 1)];
+		uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+		int64_t diff = (int64_t) (sequence - pos);
+		if (diff == 0) {
+			// Slot is free for this lap; try to claim it
+			if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+		} else if (diff < 0) {
+			// Slot still holds a sample from the previous lap: the queue is full
+			counters.overflows.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		} else {
+			pos = _tail.load(std::memory_order_relaxed);
+		}
+	}
+	slot->sample = sample;
+	slot->sequence.store(pos + 1, std::memory_order_release);
+	counters.pushed.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+/*
+** recordDrop
+** Counts a sample from producer that the owner of the queue rejected.
+*/
+void ofxScopeMpscQueue::recordDrop(int producer) {
+	if (producer < 0 || producer >= _maxProducers) return;
+	_producers[producer].drops.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*
+** pop
+** Moves up to maxSamples published samples into samples, oldest first, and
+** returns how many were moved. Stops early at a slot that has been claimed
+** but not yet published. Consumer thread only.
+*/
+size_t ofxScopeMpscQueue::pop(ofxScopeSample * samples, size_t maxSamples) {
+	size_t nPopped = 0;
+	while (nPopped < maxSamples && _capacity > 0) {
+		Slot &slot = _slots[(size_t) _head & (_capacity - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != _head + 1) break;
+		samples[nPopped++] = slot.sample;
+		// Hand the slot back to producers for the next lap
+		slot.sequence.store(_head + _capacity, std::memory_order_release);
+		_head++;
+	}
+	return nPopped;
+}
+
+size_t ofxScopeMpscQueue::getCapacity() const {
+	return _capacity;
+}
+
+int ofxScopeMpscQueue::getNumProducers() const {
+	return std::min(_nProducers.load(std::memory_order_relaxed), _maxProducers);
+}
+
+/*
+** getPushed
+** Returns the number of samples a producer queued successfully.
+*/
+uint64_t ofxScopeMpscQueue::getPushed(int producer) const {
+	if (producer < 0 || producer >= _maxProducers) return 0;
+	return _producers[producer].pushed.load(std::memory_order_relaxed);
+}
+
+/*
+** getOverflows
+** Returns the number of samples from a producer lost because the queue was full.
+*/
+uint64_t ofxScopeMpscQueue::getOverflows(int producer) const {
+	if (producer < 0 || producer >= _maxProducers) return 0;
+	return _producers[producer].overflows.load(std::memory_order_relaxed);
+}
+
+/*
+** getDrops
+** Returns the number of samples from a producer rejected by the owner.
+*/
+uint64_t ofxScopeMpscQueue::getDrops(int producer) const {
+	if (producer < 0 || producer >= _maxProducers) return 0;
+	return _producers[producer].drops.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,208 @@
+//
+//  ofxScopeQueue.h
+//
+//  Lock-free ingest queues feeding ofxScopePlot from acquisition threads
+//
+//  This work is licensed under the Creative Commons
+//  Attribution-ShareAlike 3.0 Unported License.
+//  To view a copy of this license, visit http://creativecommons.org/licenses/by-sa/3.0/.
+//
+
+#ifndef _OFX_SCOPE_QUEUE
+#define _OFX_SCOPE_QUEUE
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "ofxScopeBuffer.h"
+
+/*-------------------------------------------------
+* ofxScopeSpscQueue
+* Bounded single-producer/single-consumer queue of
+* frames (one sample per variable plus an optional
+* timestamp). One thread may push while another
+* drains, without locks. Frames are stored interleaved
+* so a drain hands contiguous runs straight to
+* ofxScopeBuffer::pushInterleaved.
+*
+* When the queue is full, newly pushed frames are
+* dropped and counted as overruns; samples already
+* queued are never overwritten under the consumer.
+*
+* setup() and copying are not thread safe. A copy gets
+* an empty queue of the same size, so copied scopes
+* never share a producer.
+*-------------------------------------------------*/
+class ofxScopeSpscQueue {
+private:
+	std::vector<float> _frames;		// [capacity][frameSize]
+	std::vector<double> _timestamps;	// [capacity], NaN when pushed without a timestamp
+	size_t _capacity;				// Frames; a power of two
+	int _frameSize;
+
+	// Producer and consumer positions live on separate cache lines
+	std::atomic<uint64_t> _tail;	// Frames pushed (written by the producer)
+	char _tailPadding[OFX_SCOPE_BUFFER_ALIGNMENT - sizeof(std::atomic<uint64_t>)];
+	std::atomic<uint64_t> _head;	// Frames drained (written by the consumer)
+	char _headPadding[OFX_SCOPE_BUFFER_ALIGNMENT - sizeof(std::atomic<uint64_t>)];
+	std::atomic<uint64_t> _overruns;	// Frames dropped because the queue was full
+
+public:
+	ofxScopeSpscQueue();
+	ofxScopeSpscQueue(const ofxScopeSpscQueue &other);
+	ofxScopeSpscQueue& operator=(const ofxScopeSpscQueue &other);
+
+	void setup(size_t capacity, int frameSize);	// capacity is rounded up to a power of two
+
+	// Producer
+	bool push(const float * frame);						// frame[frameSize]
+	bool push(const float * frame, double timestamp);	// timestamp in seconds
+	size_t push(const float * frames, const double * timestamps, size_t nFrames); // frames[nFrames][frameSize]; timestamps may be NULL
+
+	// Consumer
+	size_t peek(const float * &frames, const double * &timestamps); // Oldest contiguous run of queued frames
+	void pop(size_t nFrames);
+
+	size_t size() const;		// Frames currently queued
+	size_t getCapacity() const;
+	int getFrameSize() const;
+	uint64_t getOverruns() const;
+	uint64_t resetOverruns();	// Returns the count before resetting
+};
+
+/*-------------------------------------------------
+* ofxScopeSample
+* One sample addressed by plot ID, as carried by
+* ofxScopeMpscQueue.
+*-------------------------------------------------*/
+struct ofxScopeSample {
+	int plotId;
+	float value;
+	double timestamp;	// Seconds; NaN when unknown
+};
+
+/*-------------------------------------------------
+* ofxScopeMpscQueue
+* Bounded multi-producer/single-consumer queue of
+* ofxScopeSample. Any number of threads may push
+* concurrently while one thread drains, without locks.
+* Each slot carries a sequence number: producers claim
+* slots by advancing the tail with compare-and-swap and
+* publish them by bumping the slot's sequence, so the
+* consumer never sees a half written sample.
+*
+* Producers register with addProducer() and pass the
+* returned ID with every push; pushed samples, samples
+* lost because the queue was full (overflows) and
+* samples rejected by the owner (drops) are counted per
+* producer.
+*
+* setup() and copying are not thread safe. A copy gets
+* an empty queue of the same size with no producers.
+*-------------------------------------------------*/
+class ofxScopeMpscQueue {
+private:
+	struct Slot {
+		std::atomic<uint64_t> sequence;
+		ofxScopeSample sample;
+	};
+	struct ProducerCounters {
+		std::atomic<uint64_t> pushed;
+		std::atomic<uint64_t> overflows;
+		std::atomic<uint64_t> drops;
+		char padding[OFX_SCOPE_BUFFER_ALIGNMENT - 3 * sizeof(std::atomic<uint64_t>)];
+	};
+
+	std::unique_ptr<Slot[]> _slots;
+	size_t _capacity;				// Slots; a power of two
+	std::unique_ptr<ProducerCounters[]> _producers;
+	int _maxProducers;
+
+	std::atomic<uint64_t> _tail;	// Next slot to claim (shared by producers)
+	char _tailPadding[OFX_SCOPE_BUFFER_ALIGNMENT - sizeof(std::atomic<uint64_t>)];
+	uint64_t _head;					// Next slot to drain (consumer only)
+	std::atomic<int> _nProducers;
+
+public:
+	ofxScopeMpscQueue();
+	ofxScopeMpscQueue(const ofxScopeMpscQueue &other);
+	ofxScopeMpscQueue& operator=(const ofxScopeMpscQueue &other);
+
+	void setup(size_t capacity, int maxProducers);	// capacity is rounded up to a power of two
+
+	// Producers
+	int addProducer();		// Returns a producer ID, or -1 if maxProducers are registered
+	bool push(int producer, const ofxScopeSample &sample);
+	void recordDrop(int producer);	// Counts a sample the owner rejected
+
+	// Consumer
+	size_t pop(ofxScopeSample * samples, size_t maxSamples);	// Oldest first; returns the number popped
+
+	size_t getCapacity() const;
+	int getNumProducers() const;
+	uint64_t getPushed(int producer) const;
+	uint64_t getOverflows(int producer) const;	// Samples lost because the queue was full
+	uint64_t getDrops(int producer) const;		// Samples rejected by the owner
+};
+
+/*-------------------------------------------------
+* ofxScopeTripleBuffer
+* Hands the latest of a stream of values from one
+* writer thread to one reader thread without locks.
+* The writer fills back() and publish()es it; the
+* reader's latest() returns the newest published value
+* and keeps it stable until the next call, however
+* often the writer publishes meanwhile. Neither side
+* ever waits for the other.
+*
+* Copying is not thread safe; a copy holds copies of
+* the three slots.
+*-------------------------------------------------*/
+template <class T>
+class ofxScopeTripleBuffer {
+private:
+	static const int DIRTY = 4;	// Set in _middle when it holds an unread value
+
+	T _slots[3];
+	int _back;					// Writer's slot
+	int _front;					// Reader's slot
+	std::atomic<int> _middle;	// Slot exchanged between them, | DIRTY
+
+public:
+	ofxScopeTripleBuffer() : _back(0), _front(1), _middle(2) {}
+	ofxScopeTripleBuffer(const ofxScopeTripleBuffer &other) : _back(0), _front(1), _middle(2) {
+		*this = other;
+	}
+	ofxScopeTripleBuffer& operator=(const ofxScopeTripleBuffer &other) {
+		if (this != &other) {
+			for (int i = 0; i < 3; i++) {
+				_slots[i] = other._slots[i];
+			}
+			_back = other._back;
+			_front = other._front;
+			_middle.store(other._middle.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+		return *this;
+	}
+
+	// Writer
+	T& back() {
+		return _slots[_back];
+	}
+	void publish() {
+		_back = _middle.exchange(_back | DIRTY, std::memory_order_acq_rel) & ~DIRTY;
+	}
+
+	// Reader
+	const T& latest() {
+		if (_middle.load(std::memory_order_relaxed) & DIRTY) {
+			_front = _middle.exchange(_front, std::memory_order_acq_rel) & ~DIRTY;
+		}
+		return _slots[_front];
+	}
+};
+
+#endif
@@ -0,0 +1,226 @@
+//
+//  ofxScopeStrip.cpp
+//
+//  Wraparound offscreen strip holding the rasterized trace of one channel
+//
+//  This work is licensed under the Creative Commons
+//  Attribution-ShareAlike 3.0 Unported License.
+//  To view a copy of this license, visit http://creativecommons.org/licenses/by-sa/3.0/.
+//
+#include "ofxScopeStrip.h"
+#include <algorithm>
+#include <cmath>
+
+bool ofxScopeStrip::Style::operator==(const Style &other) const {
+	return xStep == other.xStep && bucketSize == other.bucketSize
+		&& color == other.color && lineWidth == other.lineWidth
+		&& width == other.width && height == other.height;
+}
+
+/*
+** ofxScopeStrip
+*/
+ofxScopeStrip::ofxScopeStrip() {
+	_stripWidth = 0;
+	_stripHeight = 0;
+	_margin = 0;
+	_style = Style();
+	_yScale = 0;
+	_yOffset = 0;
+	_drawn = false;
+	_end = 0;
+	_last = 0;
+	_mesh.setMode(OF_PRIMITIVE_LINE_STRIP);
+}
+
+ofxScopeStrip::ofxScopeStrip(const ofxScopeStrip &) {
+	_stripWidth = 0;
+	_stripHeight = 0;
+	_margin = 0;
+	_style = Style();
+	_yScale = 0;
+	_yOffset = 0;
+	_drawn = false;
+	_end = 0;
+	_last = 0;
+	_mesh.setMode(OF_PRIMITIVE_LINE_STRIP);
+}
+
+ofxScopeStrip& ofxScopeStrip::operator=(const ofxScopeStrip &other) {
+	if (this != &other) {
+		_fbo = ofFbo();
+		_stripWidth = 0;
+		_stripHeight = 0;
+		_style = Style();
+		invalidate();
+	}
+	return *this;
+}
+
+void ofxScopeStrip::invalidate() {
+	_drawn = false;
+}
+
+uint64_t ofxScopeStrip::getUnitSize() const {
+	return std::max(_style.bucketSize, (uint64_t) 1);
+}
+
+/*
+** unitX
+** Returns the x of a unit in the strip before wrapping: the sample itself,
+** or the middle of a bucket.
+*/
+double ofxScopeStrip::unitX(uint64_t unit) const {
+	if (_style.bucketSize == 0) {
+		return unit * (double) _style.xStep;
+	}
+	return (unit * _style.bucketSize + (_style.bucketSize - 1) / 2.) * _style.xStep;
+}
+
+/*
+** plot
+** Brings the strip up to date with samples [first, last) of a channel and
+** draws it with its top left corner at (x, y), where y below the top of the
+** plot = yScale * code + yOffset. Must be called between frames of the same
+** GL context. Returns false, compositing nothing, if samples were overwritten
+** while they were read.
+*/
+bool ofxScopeStrip::plot(const ofxScopeView &view, int channel, uint64_t first, uint64_t last, const Style &style,
+	float yScale, float yOffset, float x, float y) {
+	if (first >= last || style.width <= 0 || style.height <= 0) return true;
+
+	if (!(style == _style)) {
+		_margin = (int) ceil(style.lineWidth) + 2;
+		int stripWidth = style.width + 2 * _margin;
+		if (stripWidth != _stripWidth || 2 * style.height != _stripHeight) {
+			_stripWidth = stripWidth;
+			_stripHeight = 2 * style.height;
+			_fbo.allocate(_stripWidth, _stripHeight, GL_RGBA);
+		}
+		_style = style;
+		_drawn = false;
+	}
+
+	// Strip rows composited to plot rows [0, height)
+	float room = _style.height / 2.f;
+	float stretch = _yScale != 0 ? yScale / _yScale : 0;
+	float rowFirst = room + _yOffset - (stretch != 0 ? yOffset / stretch : 0);
+	float rows = stretch != 0 ? _style.height / stretch : 0;
+	if (!_drawn || stretch * OFX_SCOPE_STRIP_MAX_STRETCH < 1 || stretch > OFX_SCOPE_STRIP_MAX_STRETCH
+		|| rowFirst < 0 || rowFirst + rows > _stripHeight) {
+		_yScale = yScale;
+		_yOffset = yOffset;
+		rowFirst = room;
+		rows = (float) _style.height;
+		_drawn = false;
+	}
+
+	uint64_t unitSize = getUnitSize();
+	uint64_t firstUnit = first / unitSize;
+	uint64_t lastUnit = (last - 1) / unitSize;	// Unit of the newest sample
+	uint64_t end = last / unitSize;				// Units complete as of last
+	// Lines of units this far back may reach past the last final unit
+	uint64_t back = (uint64_t) ceil(_style.lineWidth / (_style.xStep * unitSize)) + 1;
+
+	if (!_drawn || last != _last) {
+		_fbo.begin();
+		ofPushStyle();
+		uint64_t from;
+		if (_drawn && _last <= last && _end <= end && _end > firstUnit + back
+			&& unitX(lastUnit) - unitX(_end - 1) < _style.width) {
+			// Clear past the last final unit, then draw from a little before it
+			clearColumns(unitX(_end - 1), unitX(lastUnit) + _margin);
+			from = _end - 1 - back;
+		} else {
+			ofClear(0, 0, 0, 0);
+			from = firstUnit;
+		}
+		drawUnits(view, channel, from, lastUnit, last);
+		ofPopStyle();
+		_fbo.end();
+		if (!view.isIntact(channel, std::max(from * unitSize, first))) {
+			invalidate();
+			return false;
+		}
+		_end = end;
+		_last = last;
+		_drawn = true;
+	}
+
+	// Composite so the strip column of the newest sample meets the right edge,
+	// stretching the strip's rows to the current y transform
+	int right = (int) fmod(floor(fmod((last - 1) * (double) _style.xStep, _stripWidth) + 0.5), _stripWidth);
+	ofPushStyle();
+	ofEnableAlphaBlending();
+	ofSetColor(255, 255, 255, 255);
+	int width = _style.width;
+	int height = _style.height;
+	if (right >= width) {
+		_fbo.getTexture().drawSubsection(x, y, width, height, right - width, rowFirst, width, rows);
+	} else {
+		int wrapped = width - right;
+		_fbo.getTexture().drawSubsection(x, y, wrapped, height, _stripWidth - wrapped, rowFirst, wrapped, rows);
+		if (right > 0) {
+			_fbo.getTexture().drawSubsection(x + wrapped, y, right, height, 0, rowFirst, right, rows);
+		}
+	}
+	ofDisableAlphaBlending();
+	ofPopStyle();
+	return true;
+}
+
+/*
+** clearColumns
+** Makes strip columns [x0, x1) transparent, wrapping around the strip.
+** Called between _fbo.begin() and end().
+*/
+void ofxScopeStrip::clearColumns(double x0, double x1) {
+	float start = (float) fmod(x0, _stripWidth);
+	float width = (float) (x1 - x0);
+	ofDisableAlphaBlending();
+	ofSetColor(0, 0, 0, 0);
+	ofRect(ofRectangle(start, 0, width, _stripHeight));
+	ofRect(ofRectangle(start - _stripWidth, 0, width, _stripHeight));
+}
+
+/*
+** drawUnits
+** Draws units [firstUnit, lastUnit] as one line strip with the strip's y
+** transform, clipping buckets to last. Vertices are placed relative to firstUnit so large sample indexes
+** keep their precision; the strip is drawn twice, one strip width apart, to
+** cover the wrap. Called between _fbo.begin() and end().
+*/
+void ofxScopeStrip::drawUnits(const ofxScopeView &view, int channel, uint64_t firstUnit, uint64_t lastUnit, uint64_t last) {
+	double baseX = unitX(firstUnit);
+	float yOffset = _yOffset + _style.height / 2.f;
+	_mesh.clear();
+	if (_style.bucketSize == 0) {
+		for (uint64_t n = firstUnit; n <= lastUnit; n++) {
+			_mesh.addVertex(ofPoint((float) (unitX(n) - baseX),
+				_yScale * view.codeAtIndex(channel, n) + yOffset));
+		}
+	} else {
+		// Buckets hold values; bring them back to codes for the strip's transform
+		const ofxScopeSampleFormat &format = view.getSampleFormat(channel);
+		for (uint64_t b = firstUnit; b <= lastUnit; b++) {
+			float min, max;
+			uint64_t bucketEnd = std::min((b + 1) * _style.bucketSize, last);
+			if (!view.getMinMax(channel, b * _style.bucketSize, bucketEnd, min, max)) continue;
+			float x = (float) (unitX(b) - baseX);
+			_mesh.addVertex(ofPoint(x, _yScale * (min - format.offset) / format.scale + yOffset));
+			_mesh.addVertex(ofPoint(x, _yScale * (max - format.offset) / format.scale + yOffset));
+		}
+	}
+
+	// Opaque, as plot() draws traces without blending
+	ofDisableAlphaBlending();
+	ofSetColor(_style.color.r, _style.color.g, _style.color.b, 255);
+	ofSetLineWidth(_style.lineWidth);
+	float start = (float) fmod(baseX, _stripWidth);
+	ofPushMatrix();
+	ofTranslate(start, 0);
+	_mesh.draw();
+	ofTranslate(-_stripWidth, 0);
+	_mesh.draw();
+	ofPopMatrix();
+}
@@ -0,0 +1,97 @@
+//
+//  ofxScopeStrip.h
+//
+//  Wraparound offscreen strip holding the rasterized trace of one channel
+//
+//  This work is licensed under the Creative Commons
+//  Attribution-ShareAlike 3.0 Unported License.
+//  To view a copy of this license, visit http://creativecommons.org/licenses/by-sa/3.0/.
+//
+
+#ifndef _OFX_SCOPE_STRIP
+#define _OFX_SCOPE_STRIP
+
+#include "ofMain.h"
+#include "ofxScopeBuffer.h"
+#include <cstddef>
+#include <cstdint>
+
+// Vertical stretch, either way, of a strip composited with a y transform other
+// than the one it was rasterized with before it is redrawn
+#define OFX_SCOPE_STRIP_MAX_STRETCH 1.25f
+
+/*-------------------------------------------------
+* ofxScopeStrip
+* Keeps the trace of one channel rasterized in an
+* offscreen strip a little wider than the plot, used as
+* a ring of pixel columns: sample n lands at column
+* n * xStep modulo the strip width. Each plot() clears
+* and draws only the columns of samples appended since
+* the previous one, then composites the strip with a
+* wrap offset so the newest sample is at the right edge.
+* The cost per frame follows the ingest rate, not the
+* length of the time window.
+*
+* Units are samples, or min/max buckets of bucketSize
+* samples aligned to absolute indexes; the newest,
+* partial bucket is redrawn until it is complete. Any
+* change of Style, a jump of more than the plot width or
+* a step back (scrolling, new setup) redraws the strip.
+*
+* The y transform is applied when compositing, so an
+* autoscaled plot does not redraw the strip every frame:
+* the strip is rasterized with the transform of its last
+* redraw and half a plot height of room above and below,
+* then stretched and shifted to the current transform. It
+* is redrawn once the stretch exceeds
+* OFX_SCOPE_STRIP_MAX_STRETCH or the plot leaves that room.
+*
+* Samples overwritten while they were rasterized (see
+* ofxScopeView::isIntact) leave the strip to be redrawn
+* and nothing composited.
+*
+* Traces are drawn opaque, as plotted directly. Copying
+* gives an empty strip.
+*-------------------------------------------------*/
+class ofxScopeStrip {
+public:
+	struct Style {
+		float xStep;			// Pixels per sample
+		uint64_t bucketSize;	// Samples per min/max bucket; 0 draws every sample
+		ofColor color;
+		float lineWidth;
+		int width;				// Plot size in pixels
+		int height;
+
+		bool operator==(const Style &other) const;
+	};
+
+private:
+	ofFbo _fbo;
+	int _stripWidth;		// Plot width plus room cleared ahead of the newest unit
+	int _stripHeight;		// Plot height plus room above and below
+	int _margin;
+	Style _style;
+	float _yScale;			// Strip row = _yScale * code + _yOffset + _style.height / 2
+	float _yOffset;
+	bool _drawn;			// False until the next plot redraws everything
+	uint64_t _end;			// Units before _end are drawn and final
+	uint64_t _last;			// Sample index after the newest drawn sample
+	ofMesh _mesh;			// Vertices of the units being drawn
+
+	uint64_t getUnitSize() const;
+	double unitX(uint64_t unit) const;	// Strip x of a unit before wrapping
+	void clearColumns(double x0, double x1);
+	void drawUnits(const ofxScopeView &view, int channel, uint64_t firstUnit, uint64_t lastUnit, uint64_t last);
+
+public:
+	ofxScopeStrip();
+	ofxScopeStrip(const ofxScopeStrip &other);
+	ofxScopeStrip& operator=(const ofxScopeStrip &other);
+
+	bool plot(const ofxScopeView &view, int channel, uint64_t first, uint64_t last, const Style &style,
+		float yScale, float yOffset, float x, float y);	// Draws samples [first, last) into the plot at (x, y)
+	void invalidate();		// Redraws everything on the next plot
+};
+
+#endif
@@ -0,0 +1,199 @@
+//
+//  ofxScopeVertexBuffer.cpp
+//
+//  Vertex buffer mirroring one ofxScopeBuffer ring for line strip rendering
+//
+//  This work is licensed under the Creative Commons
+//  Attribution-ShareAlike 3.0 Unported License.
+//  To view a copy of this license, visit http://creativecommons.org/licenses/by-sa/3.0/.
+//
+#include "ofxScopeVertexBuffer.h"
+#include <algorithm>
+
+/*
+** ofxScopeVertexBuffer
+*/
+ofxScopeVertexBuffer::ofxScopeVertexBuffer(Mode mode) {
+	_mode = mode;
+	_capacity = 0;
+	_begin = 0;
+	_end = 0;
+	_strip.setMode(OF_PRIMITIVE_LINE_STRIP);
+}
+
+ofxScopeVertexBuffer::ofxScopeVertexBuffer(const ofxScopeVertexBuffer &other) {
+	_mode = other._mode;
+	_capacity = 0;
+	_begin = 0;
+	_end = 0;
+	_strip.setMode(OF_PRIMITIVE_LINE_STRIP);
+}
+
+ofxScopeVertexBuffer& ofxScopeVertexBuffer::operator=(const ofxScopeVertexBuffer &other) {
+	if (this != &other) {
+		_mode = other._mode;
+		allocate(0);
+	}
+	return *this;
+}
+
+/*
+** allocate
+** Sizes the storage for a ring of capacity samples and forgets its contents.
+** In GPU mode this creates the vertex buffer object, so it must run on the
+** thread owning the GL context; update() calls it from plot().
+*/
+void ofxScopeVertexBuffer::allocate(size_t capacity) {
+	_capacity = capacity;
+	invalidate();
+	if (_mode == CPU) {
+		_vertices.assign(2 * (_capacity + 1), 0.f);
+		return;
+	}
+	_vertices.clear();
+	if (_capacity > 0) {
+		_gpuVertices.allocate(2 * (_capacity + 1) * sizeof(float), GL_DYNAMIC_DRAW);
+		_vbo.setVertexBuffer(_gpuVertices, 2, 2 * sizeof(float));
+	}
+}
+
+/*
+** update
+** Mirrors the samples of a channel appended since the previous update, reading
+** them from view. Indexes older than oldest are not mirrored when the buffer
+** catches up after a reset; pass the oldest index plot() may draw. Starts over
+** when the ring was reallocated or set up again, or when ingest overwrote the
+** samples being copied.
+*/
+void ofxScopeVertexBuffer::update(const ofxScopeView &view, int channel, uint64_t oldest) {
+	size_t capacity = view.getCapacity(channel);
+	if (capacity != _capacity) {
+		allocate(capacity);
+	}
+	if (_capacity == 0) return;
+
+	uint64_t end = view.getNumWritten(channel);
+	if (end < _end) {
+		invalidate();
+	}
+	// Only the newest capacity samples have a vertex
+	if (end > _capacity) {
+		oldest = std::max(oldest, end - _capacity);
+	}
+	oldest = std::min(oldest, end);
+	if (_end < oldest) {
+		_begin = oldest;
+		_end = oldest;
+	}
+
+	write(view, channel, _end, end);
+	if (!view.isIntact(channel, _end)) {
+		// Ingest overwrote samples while they were copied
+		invalidate();
+		return;
+	}
+	_end = end;
+	if (_end - _begin > _capacity) {
+		_begin = _end - _capacity;
+	}
+}
+
+/*
+** write
+** Writes the vertices of indexes [first, last) in runs of contiguous slots,
+** uploading each run with one call in GPU mode.
+*/
+void ofxScopeVertexBuffer::write(const ofxScopeView &view, int channel, uint64_t first, uint64_t last) {
+	while (first < last) {
+		size_t slot = (size_t) (first % _capacity);
+		size_t nPoints = (size_t) std::min(last - first, (uint64_t) (_capacity - slot));
+
+		float * vertices;
+		if (_mode == CPU) {
+			vertices = &_vertices[2 * slot];
+		} else {
+			_vertices.resize(2 * nPoints);
+			vertices = &_vertices[0];
+		}
+		for (size_t j = 0; j < nPoints; j++) {
+			vertices[2 * j] = (float) (slot + j);
+			vertices[2 * j + 1] = view.codeAtIndex(channel, first + j);
+		}
+
+		// Vertex capacity repeats vertex 0 one lap later
+		float wrapped[2] = { (float) _capacity, vertices[1] };
+		if (_mode == CPU) {
+			if (slot == 0) {
+				std::copy(wrapped, wrapped + 2, &_vertices[2 * _capacity]);
+			}
+		} else {
+			_gpuVertices.updateData(2 * slot * sizeof(float), 2 * nPoints * sizeof(float), vertices);
+			if (slot == 0) {
+				_gpuVertices.updateData(2 * _capacity * sizeof(float), sizeof(wrapped), wrapped);
+			}
+		}
+		first += nPoints;
+	}
+}
+
+/*
+** invalidate
+** Forgets every mirrored vertex; the next update starts over. Call after the
+** held samples change in place (clearData, a new sample format).
+*/
+void ofxScopeVertexBuffer::invalidate() {
+	_begin = 0;
+	_end = 0;
+}
+
+bool ofxScopeVertexBuffer::holds(uint64_t first, uint64_t last) const {
+	return _capacity > 0 && first < last && first >= _begin && last <= _end;
+}
+
+/*
+** draw
+** Draws indexes [first, last), which must be held, as a line strip: sample
+** last-1 at x = xNewest and each older sample xStep further left, at
+** y = yScale * code + yOffset. Vertices keep their slot as x, so the strip up
+** to the end of the ring and the strip after the wrap each get a translation.
+*/
+void ofxScopeVertexBuffer::draw(uint64_t first, uint64_t last, float xNewest, float xStep,
+	float yScale, float yOffset) {
+	if (!holds(first, last)) return;
+
+	size_t nPoints = (size_t) (last - first);
+	size_t slot = (size_t) (first % _capacity);
+	uint64_t base = first - slot;	// Index of vertex 0 in this lap
+	size_t nFirst = std::min(nPoints, _capacity + 1 - slot);
+
+	ofPushMatrix();
+	ofTranslate(xNewest - (float) (last - 1 - base) * xStep, yOffset);
+	ofScale(xStep, yScale);
+	drawStrip(slot, nFirst);
+	if (nPoints > nFirst) {
+		// Next lap, starting again from vertex 0 where the first strip ended
+		ofTranslate((float) _capacity, 0);
+		drawStrip(0, nPoints - nFirst + 1);
+	}
+	ofPopMatrix();
+}
+
+void ofxScopeVertexBuffer::drawStrip(size_t firstVertex, size_t nVertices) {
+	if (_mode == GPU) {
+		_vbo.draw(GL_LINE_STRIP, (int) firstVertex, (int) nVertices);
+		return;
+	}
+	_strip.clear();
+	for (size_t v = firstVertex; v < firstVertex + nVertices; v++) {
+		_strip.addVertex(ofPoint(_vertices[2 * v], _vertices[2 * v + 1]));
+	}
+	_strip.draw();
+}
+
+ofxScopeVertexBuffer::Mode ofxScopeVertexBuffer::getMode() const {
+	return _mode;
+}
+
+size_t ofxScopeVertexBuffer::getCapacity() const {
+	return _capacity;
+}
@@ -0,0 +1,81 @@
+//
+//  ofxScopeVertexBuffer.h
+//
+//  Vertex buffer mirroring one ofxScopeBuffer ring for line strip rendering
+//
+//  This work is licensed under the Creative Commons
+//  Attribution-ShareAlike 3.0 Unported License.
+//  To view a copy of this license, visit http://creativecommons.org/licenses/by-sa/3.0/.
+//
+
+#ifndef _OFX_SCOPE_VERTEX_BUFFER
+#define _OFX_SCOPE_VERTEX_BUFFER
+
+#include "ofMain.h"
+#include "ofxScopeBuffer.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/*-------------------------------------------------
+* ofxScopeVertexBuffer
+* Vertices of one channel laid out like its ring:
+* the sample with absolute index n is vertex n % capacity,
+* stored as (n % capacity, code). Vertex capacity repeats
+* vertex 0, so any run of indexes draws as at most two
+* strips that meet. update() writes only the samples
+* appended since the previous update; scrolling and the
+* y scale/offset are applied as the model view transform,
+* so vertices are never rewritten once written.
+*
+* GPU keeps the vertices in a persistent vertex buffer
+* object and uploads new samples in place. CPU keeps them
+* in memory and streams the visible range each draw, for
+* software GL or headless use; both behave the same.
+*
+* Copying is not thread safe. A copy gets an empty buffer
+* in the same mode, so copied scopes never share vertices.
+*-------------------------------------------------*/
+#ifdef OFX_SCOPE_CPU_VERTICES
+#define OFX_SCOPE_VERTEX_MODE ofxScopeVertexBuffer::CPU
+#else
+#define OFX_SCOPE_VERTEX_MODE ofxScopeVertexBuffer::GPU
+#endif
+
+class ofxScopeVertexBuffer {
+public:
+	enum Mode {
+		GPU,
+		CPU
+	};
+
+private:
+	Mode _mode;
+	size_t _capacity;			// Samples mirrored; one vertex more is stored
+	uint64_t _begin;			// Oldest mirrored index
+	uint64_t _end;				// Index after the newest mirrored index
+	std::vector<float> _vertices;	// CPU: [capacity + 1][x, y]; GPU: staging for one upload
+	ofBufferObject _gpuVertices;
+	ofVbo _vbo;
+	ofMesh _strip;				// CPU: vertices of the strip being drawn
+
+	void allocate(size_t capacity);
+	void write(const ofxScopeView &view, int channel, uint64_t first, uint64_t last);
+	void drawStrip(size_t firstVertex, size_t nVertices);
+
+public:
+	ofxScopeVertexBuffer(Mode mode = OFX_SCOPE_VERTEX_MODE);
+	ofxScopeVertexBuffer(const ofxScopeVertexBuffer &other);
+	ofxScopeVertexBuffer& operator=(const ofxScopeVertexBuffer &other);
+
+	void update(const ofxScopeView &view, int channel, uint64_t oldest);	// Mirrors [oldest, newest]; oldest is a hint
+	void invalidate();		// Forgets every mirrored vertex
+	bool holds(uint64_t first, uint64_t last) const;	// True if indexes [first, last) are mirrored
+	void draw(uint64_t first, uint64_t last, float xNewest, float xStep,
+		float yScale, float yOffset);	// Sample last-1 at xNewest, older ones xStep apart; y = yScale * code + yOffset
+
+	Mode getMode() const;
+	size_t getCapacity() const;
+};
+
+#endif